@@ -0,0 +1,224 @@
+#pragma once
+#include "MathExt.h"
+#include "Vec3.h"
+#include "Resource.h"
+#include "CLTypes.h"
+#include <vector>
+#include <float.h>
+
+using namespace std;
+
+struct AABB
+{
+	Vec3 bMin;
+	Vec3 bMax;
+public:
+	AABB()
+	{
+		Reset();
+	}
+	void Reset()
+	{
+		bMin = Vec3(FLT_MAX, FLT_MAX, FLT_MAX);
+		bMax = Vec3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	}
+	void Grow(const Vec3& p)
+	{
+		bMin.set(min(bMin.x, p.x), min(bMin.y, p.y), min(bMin.z, p.z));
+		bMax.set(max(bMax.x, p.x), max(bMax.y, p.y), max(bMax.z, p.z));
+	}
+	void Grow(const AABB& box)
+	{
+		if (box.bMin.x > box.bMax.x) { return; }
+		Grow(box.bMin);
+		Grow(box.bMax);
+	}
+	Vec3 Center() const
+	{
+		return bMin.VectAvg(bMax);
+	}
+	float Area() const
+	{
+		Vec3 e = bMax.VectSub(bMin);
+		if (e.x < 0.0f) { return 0.0f; }
+		return 2.0f * (e.x*e.y + e.y*e.z + e.z*e.x);
+	}
+};
+
+class BVH
+{
+public:
+	vector<cl_BVHNode> nodes;
+	vector<UINT32> indices;
+private:
+	vector<Vec3> centroids;
+	const AABB* primBounds;
+public:
+	BVH()
+	{
+		primBounds = nullptr;
+	}
+	UINT32 NodeCount() const
+	{
+		return nodes.size();
+	}
+	UINT32 IndexCount() const
+	{
+		return indices.size();
+	}
+	void Clear()
+	{
+		nodes.clear();
+		indices.clear();
+	}
+	// builds a binned SAH hierarchy over the given primitive bounds
+	void Build(const AABB* bounds, const UINT32 count)
+	{
+		Clear();
+		primBounds = bounds;
+		indices.resize(count);
+		centroids.resize(count);
+		nodes.reserve(max(count * 2, (UINT32)1));
+
+		for (UINT32 i = 0; i < count; i++) {
+			indices[i] = i;
+			centroids[i] = bounds[i].Center();
+		}
+
+		cl_BVHNode root;
+		root.leftFirst = 0;
+		root.tCount = count;
+		nodes.push_back(root);
+		UpdateBounds(0);
+
+		// an empty hierarchy is a single leaf which nothing can hit
+		if (count > 0) { Subdivide(0, 0); }
+
+		centroids.clear();
+		primBounds = nullptr;
+	}
+private:
+	void SetBounds(cl_BVHNode& node, const AABB& box)
+	{
+		node.bMin[0] = box.bMin.x; node.bMin[1] = box.bMin.y; node.bMin[2] = box.bMin.z;
+		node.bMax[0] = box.bMax.x; node.bMax[1] = box.bMax.y; node.bMax[2] = box.bMax.z;
+	}
+	void UpdateBounds(const UINT32 ni)
+	{
+		AABB box;
+		cl_BVHNode& node = nodes[ni];
+		for (UINT32 i = 0; i < node.tCount; i++) {
+			box.Grow(primBounds[indices[node.leftFirst+i]]);
+		}
+		SetBounds(node, box);
+	}
+	float NodeArea(const cl_BVHNode& node) const
+	{
+		AABB box;
+		box.bMin = Vec3(node.bMin[0], node.bMin[1], node.bMin[2]);
+		box.bMax = Vec3(node.bMax[0], node.bMax[1], node.bMax[2]);
+		return box.Area();
+	}
+	float FindBestSplit(const cl_BVHNode& node, int& axis, float& splitPos) const
+	{
+		float bestCost = FLT_MAX;
+		AABB cBox;
+
+		for (UINT32 i = 0; i < node.tCount; i++) {
+			cBox.Grow(centroids[indices[node.leftFirst+i]]);
+		}
+
+		for (int a = 0; a < 3; a++) {
+			float bMin = cBox.bMin.vector.s[a];
+			float bMax = cBox.bMax.vector.s[a];
+			if (bMin == bMax) { continue; }
+
+			AABB binBox[BVH_SAH_BINS];
+			UINT32 binCount[BVH_SAH_BINS] = {0};
+			float scale = BVH_SAH_BINS / (bMax - bMin);
+
+			for (UINT32 i = 0; i < node.tCount; i++) {
+				UINT32 pi = indices[node.leftFirst+i];
+				int bi = min(BVH_SAH_BINS-1, (int)((centroids[pi].vector.s[a] - bMin) * scale));
+				binCount[bi]++;
+				binBox[bi].Grow(primBounds[pi]);
+			}
+
+			// sweep the bins from both sides to get every plane's cost
+			float leftArea[BVH_SAH_BINS-1], rightArea[BVH_SAH_BINS-1];
+			UINT32 leftCount[BVH_SAH_BINS-1], rightCount[BVH_SAH_BINS-1];
+			AABB leftBox, rightBox;
+			UINT32 leftSum = 0, rightSum = 0;
+
+			for (int b = 0; b < BVH_SAH_BINS-1; b++) {
+				leftSum += binCount[b];
+				leftCount[b] = leftSum;
+				leftBox.Grow(binBox[b]);
+				leftArea[b] = leftBox.Area();
+				rightSum += binCount[BVH_SAH_BINS-1-b];
+				rightCount[BVH_SAH_BINS-2-b] = rightSum;
+				rightBox.Grow(binBox[BVH_SAH_BINS-1-b]);
+				rightArea[BVH_SAH_BINS-2-b] = rightBox.Area();
+			}
+
+			for (int b = 0; b < BVH_SAH_BINS-1; b++) {
+				if (leftCount[b] == 0 || rightCount[b] == 0) { continue; }
+				float cost = leftCount[b] * leftArea[b] + rightCount[b] * rightArea[b];
+				if (cost < bestCost) {
+					bestCost = cost;
+					axis = a;
+					splitPos = bMin + (b + 1) / scale;
+				}
+			}
+		}
+
+		return bestCost;
+	}
+	void Subdivide(const UINT32 ni, const UINT32 depth)
+	{
+		if (nodes[ni].tCount <= BVH_MAX_LEAF || depth >= BVH_MAX_DEPTH) { return; }
+
+		int axis = 0;
+		float splitPos = 0.0f;
+		float splitCost = FindBestSplit(nodes[ni], axis, splitPos);
+		float leafCost = nodes[ni].tCount * NodeArea(nodes[ni]);
+
+		// stop if no split is cheaper than testing every primitive
+		if (splitCost >= leafCost) { return; }
+
+		UINT32 first = nodes[ni].leftFirst;
+		UINT32 count = nodes[ni].tCount;
+		UINT32 i = first;
+		UINT32 j = first + count - 1;
+
+		while (i <= j) {
+			if (centroids[indices[i]].vector.s[axis] < splitPos) {
+				i++;
+			} else {
+				swap(indices[i], indices[j]);
+				if (j-- == 0) { break; }
+			}
+		}
+
+		UINT32 leftCount = i - first;
+		if (leftCount == 0 || leftCount == count) { return; }
+
+		// children are always stored next to each other
+		UINT32 li = nodes.size();
+		cl_BVHNode left, right;
+		left.leftFirst = first;
+		left.tCount = leftCount;
+		right.leftFirst = i;
+		right.tCount = count - leftCount;
+		nodes.push_back(left);
+		nodes.push_back(right);
+
+		nodes[ni].leftFirst = li;
+		nodes[ni].tCount = 0;
+
+		UpdateBounds(li);
+		UpdateBounds(li+1);
+		Subdivide(li, depth+1);
+		Subdivide(li+1, depth+1);
+	}
+};
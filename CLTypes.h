@@ -1,115 +1,209 @@
-#pragma once
-#include "cll.h"
-
-struct cl_RGB32
-{
-	cl_uchar CL_ALIGNED(4) s[4];
-}; // 4 bytes
-
-struct cl_MeshInfo
-{
-	cl_uint tCount;
-	cl_uint vCount;
-	cl_uint nCount;
-	cl_float radius;
-	cl_float3 center;
-}; // 32 bytes
-
-struct cl_SurfInfo
-{
-	cl_uint layers;
-	cl_uint height;
-	cl_uint width;
-	cl_uint count;
-}; // 16 bytes
-
-struct cl_ObjectInfo
-{
-	cl_float3 center;
-	cl_float3 lastPos;
-	cl_float3 position;
-	cl_float3 orientation;
-	cl_float3 velocity;
-	cl_float3 rotation;
-	cl_float radius;
-	cl_float radius2;
-	cl_float mass;
-	cl_float scale;
-	cl_RGB32 color;
-	cl_int type;
-	cl_uint index;
-	cl_uint boolBits;
-}; // 128 bytes
-
-struct cl_Material
-{
-	cl_float3 ambient;
-	cl_float3 diffuse;
-	cl_float3 specular;
-	cl_float shininess;
-	cl_float glossiness;
-	cl_float reflectivity;
-	cl_float transparency;
-}; // 64 bytes
-
-struct cl_Substance
-{
-	cl_uint type;
-	cl_float density;
-	cl_float friction;
-	cl_float hardness;
-	cl_float rigidity;
-	cl_float strength;
-	cl_float roughness;
-	cl_float elasticity;
-}; // 32 bytes
-
-struct cl_Triangle
-{
-	cl_float2 texMap[3];
-	cl_uint vertIndex[3];
-	cl_uint normIndex[3];
-	cl_uint texIndex;
-	cl_uint matIndex;
-	cl_uint subIndex;
-	cl_uint type;
-}; // 64 bytes
-
-struct cl_AAInfo 
-{
-	cl_uint lvl;
-	cl_uint dim;
-	cl_float inc;
-	cl_float div;
-};
-
-struct cl_RenderInfo
-{	
-	cl_AAInfo aa_info;
-	cl_uint pixels_X;
-	cl_uint t_depth;
-	cl_float cam_foc;
-	cl_float cam_apt;
-	cl_float3 cam_pos;
-	cl_float3 cam_ori;
-	cl_float3 cam_fwd;
-	cl_float3 cam_rgt;
-	cl_float3 cam_up;
-	cl_float3 bl_ray;
-}; // 128 bytes
-
-struct cl_RayIntersect
-{
-	union {
-		struct {
-			cl_float3 point;
-			cl_float3 normal;
-		};
-		struct {
-			cl_float pnt[3];
-			cl_float depth;
-			cl_float nrm[3];
-			cl_uint matIndex;
-		};
-	};
+#pragma once
+#include "cll.h"
+
+struct cl_RGB32
+{
+	cl_uchar CL_ALIGNED(4) s[4];
+}; // 4 bytes
+
+struct cl_MeshInfo
+{
+	cl_uint tCount;
+	cl_uint vCount;
+	cl_uint nCount;
+	cl_float radius;
+	cl_float3 center;
+	cl_uint vOffset;
+	cl_uint tOffset;
+	cl_uint bOffset;
+	cl_uint iOffset;
+}; // 48 bytes
+
+struct cl_SurfInfo
+{
+	cl_uint layers;
+	cl_uint height;
+	cl_uint width;
+	cl_uint count;
+}; // 16 bytes
+
+struct cl_TexInfo
+{
+	cl_uint x;
+	cl_uint y;
+	cl_uint width;
+	cl_uint height;
+	cl_uint layer;
+	cl_uint levels;
+	cl_uint offset;
+	cl_uint format;
+}; // 32 bytes
+
+struct cl_Matrix3x4
+{
+	cl_float4 row[3];
+}; // 48 bytes
+
+struct cl_ObjectInfo
+{
+	cl_float3 center;
+	cl_float3 lastPos;
+	cl_float3 position;
+	cl_float3 orientation;
+	cl_float3 velocity;
+	cl_float3 rotation;
+	cl_float radius;
+	cl_float radius2;
+	cl_float mass;
+	cl_float scale;
+	cl_RGB32 color;
+	cl_int type;
+	cl_uint index;
+	cl_uint boolBits;
+	cl_Matrix3x4 toWorld;
+	cl_Matrix3x4 toObject;
+}; // 224 bytes
+
+struct cl_Material
+{
+	cl_float3 ambient;
+	cl_float3 diffuse;
+	cl_float3 specular;
+	cl_float shininess;
+	cl_float glossiness;
+	cl_float reflectivity;
+	cl_float transparency;
+}; // 64 bytes
+
+struct cl_Substance
+{
+	cl_uint type;
+	cl_float density;
+	cl_float friction;
+	cl_float hardness;
+	cl_float rigidity;
+	cl_float strength;
+	cl_float roughness;
+	cl_float elasticity;
+}; // 32 bytes
+
+struct cl_Triangle
+{
+	cl_float2 texMap[3];
+	cl_uint vertIndex[3];
+	cl_uint normIndex[3];
+	cl_uint texIndex;
+	cl_uint matIndex;
+	cl_uint subIndex;
+	cl_uint type;
+}; // 64 bytes
+
+// compact triangle for quantized meshes that fit 16 bit indexes, texture coordinates are half floats
+struct cl_PackedTri
+{
+	cl_ushort2 texMap[3];
+	cl_ushort vertIndex[3];
+	cl_ushort normIndex[3];
+	cl_ushort texIndex;
+	cl_ushort matIndex;
+	cl_ushort subIndex;
+	cl_ushort type;
+}; // 32 bytes
+
+struct cl_BVHNode
+{
+	cl_float bMin[3];
+	cl_uint leftFirst;
+	cl_float bMax[3];
+	cl_uint tCount;
+}; // 32 bytes
+
+struct cl_Instance
+{
+	cl_ObjectInfo object;
+	cl_MeshInfo mesh;
+	cl_TexInfo tex;
+	cl_uint wvOffset;
+	cl_uint texAlpha;
+	cl_uint occluder;
+	cl_uint objectId;
+	cl_Matrix3x4 lastToWorld;
+}; // 368 bytes
+
+struct cl_Light
+{
+	cl_float3 position;
+	cl_float3 direction;
+	cl_float3 color;
+	cl_float range;
+	cl_float power;
+	cl_uint type;
+	cl_uint pad;
+}; // 64 bytes
+
+struct cl_ClusterInfo
+{
+	cl_uint tiles_X;
+	cl_uint tiles_Y;
+	cl_uint tile_size;
+	cl_uint slices;
+	cl_float near_z;
+	cl_float log_scale;
+	cl_uint light_first;
+	cl_uint light_count;
+}; // 32 bytes
+
+struct cl_SecRay
+{
+	cl_float3 origin;
+	cl_float3 dir;
+	cl_float3 color;
+	cl_float weight;
+	cl_float cone;
+	cl_float spread;
+	cl_uint pad;
+}; // 64 bytes
+
+struct cl_AAInfo 
+{
+	cl_uint lvl;
+	cl_uint dim;
+	cl_float inc;
+	cl_float div;
+};
+
+struct cl_RenderInfo
+{	
+	cl_AAInfo aa_info;
+	cl_uint pixels_X;
+	cl_uint t_depth;
+	cl_float cam_foc;
+	cl_float cam_apt;
+	cl_float3 cam_pos;
+	cl_float3 cam_ori;
+	cl_float3 cam_fwd;
+	cl_float3 cam_rgt;
+	cl_float3 cam_up;
+	cl_float3 bl_ray;
+	cl_Matrix3x4 cam_mat;
+	cl_uint ray_count;
+	cl_float jitter_X;
+	cl_float jitter_Y;
+	cl_uint pad;
+}; // 192 bytes
+
+struct cl_RayIntersect
+{
+	union {
+		struct {
+			cl_float3 point;
+			cl_float3 normal;
+		};
+		struct {
+			cl_float pnt[3];
+			cl_float depth;
+			cl_float nrm[3];
+			cl_uint matIndex;
+		};
+	};
 }; // 32 bytes
\ No newline at end of file
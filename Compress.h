@@ -0,0 +1,255 @@
+#pragma once
+#include "Colors.h"
+#include "MathExt.h"
+#include "Resource.h"
+#include "CLTypes.h"
+#include <vector>
+#include <math.h>
+#include <climits>
+#include <string.h>
+
+using namespace std;
+
+// 4x4 texel blocks, BC1 stores two 565 end colors and a 2 bit index per texel,
+// BC3 adds two end alphas and a 3 bit index per texel in front of the colors
+
+inline UINT32 Pack565(const int r, const int g, const int b)
+{
+	return ((r * 31 + 127) / 255 << 11) | ((g * 63 + 127) / 255 << 5) | ((b * 31 + 127) / 255);
+}
+
+inline void Unpack565(const UINT32 c, int* rgb)
+{
+	rgb[0] = ((c >> 11) & 31) * 255 / 31;
+	rgb[1] = ((c >> 5) & 63) * 255 / 63;
+	rgb[2] = (c & 31) * 255 / 31;
+}
+
+// palette must match DecodeTexel in compute.cl
+inline void ColorPalette(const UINT32 c0, const UINT32 c1, int palette[4][3])
+{
+	Unpack565(c0, palette[0]);
+	Unpack565(c1, palette[1]);
+	for (int i = 0; i < 3; i++) {
+		palette[2][i] = (2 * palette[0][i] + palette[1][i]) / 3;
+		palette[3][i] = (palette[0][i] + 2 * palette[1][i]) / 3;
+	}
+}
+
+inline void AlphaPalette(const UINT32 a0, const UINT32 a1, int palette[8])
+{
+	palette[0] = a0;
+	palette[1] = a1;
+	for (int i = 2; i < 8; i++) {
+		palette[i] = ((8 - i) * a0 + (i - 1) * a1) / 7;
+	}
+}
+
+inline RGB32 BlockTexel(const RGB32* colors, const UINT32 width, const UINT32 height, const UINT32 x, const UINT32 y)
+{
+	// blocks past the edge repeat the last row and column
+	return colors[min(x, width-1) + min(y, height-1) * width];
+}
+
+inline cl_uint2 EncodeColorBlock(const RGB32* texels)
+{
+	int lo[3] = {255, 255, 255}, hi[3] = {0, 0, 0};
+	cl_uint2 block;
+
+	// the color box corners make cheap end points
+	for (int t = 0; t < 16; t++) {
+		int rgb[3] = {texels[t].red, texels[t].green, texels[t].blue};
+		for (int i = 0; i < 3; i++) {
+			lo[i] = min(lo[i], rgb[i]);
+			hi[i] = max(hi[i], rgb[i]);
+		}
+	}
+
+	UINT32 c0 = Pack565(hi[0], hi[1], hi[2]);
+	UINT32 c1 = Pack565(lo[0], lo[1], lo[2]);
+	block.s[0] = c0 | (c1 << 16);
+	block.s[1] = 0;
+
+	// equal end points would switch to the three color mode
+	if (c0 == c1) { return block; }
+
+	int palette[4][3];
+	ColorPalette(c0, c1, palette);
+
+	for (int t = 0; t < 16; t++) {
+		int rgb[3] = {texels[t].red, texels[t].green, texels[t].blue};
+		int best = 0, bestDist = INT_MAX;
+		for (int p = 0; p < 4; p++) {
+			int dist = 0;
+			for (int i = 0; i < 3; i++) { dist += (rgb[i] - palette[p][i]) * (rgb[i] - palette[p][i]); }
+			if (dist < bestDist) { bestDist = dist; best = p; }
+		}
+		block.s[1] |= best << (t * 2);
+	}
+
+	return block;
+}
+
+inline cl_uint2 EncodeAlphaBlock(const RGB32* texels)
+{
+	int lo = 255, hi = 0;
+	cl_uint2 block;
+
+	for (int t = 0; t < 16; t++) {
+		lo = min(lo, (int)texels[t].alpha);
+		hi = max(hi, (int)texels[t].alpha);
+	}
+
+	block.s[0] = hi | (lo << 8);
+	block.s[1] = 0;
+
+	if (hi == lo) { return block; }
+
+	int palette[8];
+	AlphaPalette(hi, lo, palette);
+	unsigned long long bits = 0;
+
+	for (int t = 0; t < 16; t++) {
+		int best = 0, bestDist = INT_MAX;
+		for (int p = 0; p < 8; p++) {
+			int dist = abs(texels[t].alpha - palette[p]);
+			if (dist < bestDist) { bestDist = dist; best = p; }
+		}
+		bits |= (unsigned long long)best << (t * 3);
+	}
+
+	// 48 bits of indexes start after the two end alphas
+	block.s[0] |= (UINT32)(bits << 16);
+	block.s[1] = (UINT32)(bits >> 16);
+	return block;
+}
+
+inline RGB32 DecodeBlockTexel(const cl_uint2* block, const UINT32 format, const UINT32 t)
+{
+	const cl_uint2& cb = block[(format == TEX_BC3) ? 1 : 0];
+	UINT32 c0 = cb.s[0] & 0xFFFF, c1 = cb.s[0] >> 16;
+	int palette[4][3];
+	ColorPalette(c0, c1, palette);
+	int* rgb = palette[(c0 == c1) ? 0 : (cb.s[1] >> (t * 2)) & 3];
+	RGB32 result = CREATE_ARGB32(rgb[0], rgb[1], rgb[2], 255);
+
+	if (format == TEX_BC3) {
+		const cl_uint2& ab = block[0];
+		int alphas[8];
+		AlphaPalette(ab.s[0] & 0xFF, (ab.s[0] >> 8) & 0xFF, alphas);
+		unsigned long long bits = (ab.s[0] >> 16) | ((unsigned long long)ab.s[1] << 16);
+		result.alpha = alphas[(alphas[0] == alphas[1]) ? 0 : (bits >> (t * 3)) & 7];
+	}
+
+	return result;
+}
+
+// packs a surface into blocks, alpha is only kept if the surface has translucent texels
+inline void CompressSurface(const RGB32* colors, const UINT32 width, const UINT32 height, 
+							const UINT32 format, vector<cl_uint2>& blocks)
+{
+	RGB32 texels[16];
+
+	for (UINT32 by = 0; by < height; by += 4) {
+		for (UINT32 bx = 0; bx < width; bx += 4) {
+			for (UINT32 t = 0; t < 16; t++) {
+				texels[t] = BlockTexel(colors, width, height, bx + (t & 3), by + (t >> 2));
+			}
+			if (format == TEX_BC3) { blocks.push_back(EncodeAlphaBlock(texels)); }
+			blocks.push_back(EncodeColorBlock(texels));
+		}
+	}
+}
+
+// octahedral map of a unit vector into two 16 bit values
+inline cl_ushort2 OctEncode(float x, float y, float z)
+{
+	float len = fabs(x) + fabs(y) + fabs(z);
+	cl_ushort2 result;
+
+	if (len == 0.0f) { z = len = 1.0f; }
+	x /= len; y /= len; z /= len;
+
+	// the lower half folds over the diagonals of the upper half
+	if (z < 0.0f) {
+		float fx = (1.0f - fabs(y)) * ((x >= 0.0f) ? 1.0f : -1.0f);
+		float fy = (1.0f - fabs(x)) * ((y >= 0.0f) ? 1.0f : -1.0f);
+		x = fx; y = fy;
+	}
+
+	result.s[0] = (cl_ushort)((x * 0.5f + 0.5f) * 65535.0f + 0.5f);
+	result.s[1] = (cl_ushort)((y * 0.5f + 0.5f) * 65535.0f + 0.5f);
+	return result;
+}
+
+// unit vector back from OctEncode, the folded half is unfolded along the diagonals
+inline cl_float3 OctDecode(const cl_ushort2 oct)
+{
+	float x = (oct.s[0] / 65535.0f) * 2.0f - 1.0f;
+	float y = (oct.s[1] / 65535.0f) * 2.0f - 1.0f;
+	float z = 1.0f - fabs(x) - fabs(y);
+	float t = max(-z, 0.0f);
+	x += (x >= 0.0f) ? -t : t;
+	y += (y >= 0.0f) ? -t : t;
+
+	float len = sqrt(x*x + y*y + z*z);
+	cl_float3 result = {};
+	result.s[0] = x / len;
+	result.s[1] = y / len;
+	result.s[2] = z / len;
+	return result;
+}
+
+// distance between a unit vector and its packed copy, roughly the angle in radians
+inline float OctError(float x, float y, float z)
+{
+	float len = sqrt(x*x + y*y + z*z);
+	if (len == 0.0f) { return 0.0f; }
+	x /= len; y /= len; z /= len;
+
+	cl_float3 back = OctDecode(OctEncode(x, y, z));
+	float dx = back.s[0] - x, dy = back.s[1] - y, dz = back.s[2] - z;
+	return sqrt(dx*dx + dy*dy + dz*dz);
+}
+
+// small values flush to zero and large ones clamp to infinity
+inline cl_ushort FloatToHalf(const float f)
+{
+	UINT32 bits;
+	memcpy(&bits, &f, sizeof(bits));
+	UINT32 sign = (bits >> 16) & 0x8000;
+	int exp = (int)((bits >> 23) & 0xFF) - 127 + 15;
+	UINT32 mant = bits & 0x7FFFFF;
+
+	if (exp <= 0) { return (cl_ushort)sign; }
+	if (exp >= 31) { return (cl_ushort)(sign | 0x7C00); }
+
+	// rounding may carry into the exponent which is still correct
+	UINT32 half = sign | (exp << 10) | (mant >> 13);
+	if (mant & 0x1000) { half++; }
+	return (cl_ushort)half;
+}
+
+// peak signal to noise ratio of the decoded blocks against the source texels
+inline double CompressedPSNR(const RGB32* colors, const UINT32 width, const UINT32 height, 
+							 const UINT32 format, const cl_uint2* blocks)
+{
+	UINT32 units = (format == TEX_BC3) ? 2 : 1;
+	UINT32 blocksX = (width + 3) / 4;
+	double errSum = 0.0;
+
+	for (UINT32 y = 0; y < height; y++) {
+		for (UINT32 x = 0; x < width; x++) {
+			const cl_uint2* block = blocks + ((y / 4) * blocksX + (x / 4)) * units;
+			RGB32 dec = DecodeBlockTexel(block, format, ((y & 3) * 4) + (x & 3));
+			RGB32 src = colors[x + y * width];
+			double dr = dec.red - src.red, dg = dec.green - src.green;
+			double db = dec.blue - src.blue, da = dec.alpha - src.alpha;
+			errSum += dr*dr + dg*dg + db*db + da*da;
+		}
+	}
+
+	double mse = errSum / (width * height * 4.0);
+	if (mse == 0.0) { return 99.0; }
+	return 10.0 * log10((255.0 * 255.0) / mse);
+}
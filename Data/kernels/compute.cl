@@ -10,6 +10,80 @@ __constant unsigned int m_isLightObj = 0x04;
 __constant unsigned int m_showBF = 0x02;
 __constant unsigned int m_bCached = 0x01;
 
+// texture coordinates are in texels of the whole pool layer
+__constant sampler_t tex_sampler = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_CLAMP_TO_EDGE | CLK_FILTER_LINEAR;
+
+// must match TEX_BC1 and TEX_BC3 in Resource.h
+#define TEX_BC1 1
+#define TEX_BC3 3
+
+// quantized meshes store positions and normals as 16 bit values
+#ifdef MESH_QUANT
+#define VERT_POOL __global ushort4*
+#else
+#define VERT_POOL __global float3*
+#endif
+
+// triangles are packed with 16 bit indexes when every mesh is small enough
+#ifdef SHORT_INDEX
+#define TRI_POOL __global PackedTri*
+#define TRI_FACE ushort4
+#else
+#define TRI_POOL __global Triangle*
+#define TRI_FACE uint4
+#endif
+
+// compressed textures are decoded by hand from a buffer of 4x4 blocks
+#ifdef TEX_BC
+#define TEX_POOL __global uint2*
+#else
+#define TEX_POOL read_only image2d_array_t
+#endif
+
+// sub-rays per pixel and layers per ray are fixed when the program is built
+#if !defined(AA_LVL) || !defined(AA_DIM) || !defined(T_DEPTH)
+#error "AA_LVL, AA_DIM and T_DEPTH must be defined when building the program"
+#endif
+
+// without SHOW_BF back faces are culled on every object
+#if SHOW_BF
+#define BackFaces(info) (((info).boolBits & m_showBF) != 0)
+#else
+#define BackFaces(info) false
+#endif
+
+// must exceed BVH_MAX_DEPTH in Resource.h
+#define BVH_STACK_SIZE 32
+
+// must match WAVE_SCAN_SIZE in Resource.h
+#define SCAN_SIZE 256
+
+// triangles shared through local memory per chunk
+#define TRI_TILE_SIZE 64
+
+// material index given to hits on light objects, which are never shaded
+#define LIGHT_MAT 0xFFFFFFFF
+
+// shadow rays start this far off the surface to avoid self shadowing
+#define SHADOW_BIAS 0.05f
+
+// must match CLUSTER_LIGHTS in Resource.h
+#define CLUSTER_LIGHTS 32
+
+// reflection rays start this far off the surface to avoid hitting it again
+#define REFL_BIAS 0.05f
+
+// neighbouring pixels further apart than this in relative depth or summed color get sub-rays
+#define EDGE_DEPTH 0.05f
+#define EDGE_COLOR 48.0f
+
+// weight of the new frame when blending with history, and the relative depth change still accepted as the same surface
+#define TEMPORAL_BLEND 0.2f
+#define TEMPORAL_DEPTH 0.02f
+
+// history id of pixels which hit nothing
+#define NO_HIT 0xFFFFFFFF
+
 // ------------------------------ //
 // ------ TYPE DEFINITIONS ------ //
 // ------------------------------ //
@@ -25,10 +99,6 @@ typedef struct {
 	unsigned char alpha;
 } RGB32;
 
-typedef struct {
-	RGB32 colors[4];
-} RGB32_x4;
-
 typedef struct {
 	float3 ambient;
 	float3 diffuse;
@@ -60,20 +130,44 @@ typedef struct {
 	unsigned int type;
 } Triangle;
 
+// half precision texture coordinates and 16 bit indexes
+typedef struct {
+	ushort2 texMap[3];
+	ushort vertIndex[3];
+	ushort normIndex[3];
+	ushort texIndex;
+	ushort matIndex;
+	ushort subIndex;
+	ushort type;
+} PackedTri;
+
 typedef struct {
 	unsigned int tCount;
 	unsigned int vCount;
 	unsigned int nCount;
 	float radius;
 	float3 center;
+	unsigned int vOffset;
+	unsigned int tOffset;
+	unsigned int bOffset;
+	unsigned int iOffset;
 } MeshInfo;
 
+// where one texture level sits in the texture pool
 typedef struct {
-	unsigned int layers;
-	unsigned int height;
+	unsigned int x;
+	unsigned int y;
 	unsigned int width;
-	unsigned int count;
-} SurfInfo;
+	unsigned int height;
+	unsigned int layer;
+	unsigned int levels;
+	unsigned int offset;
+	unsigned int format;
+} TexInfo;
+
+typedef struct {
+	float4 row[3];
+} Matrix3x4;
 
 typedef struct {
 	float3 center;
@@ -90,8 +184,60 @@ typedef struct {
 	int type;
 	unsigned int index;
 	unsigned int boolBits;
+	Matrix3x4 toWorld;
+	Matrix3x4 toObject;
 } ObjectInfo;
 
+typedef struct {
+	ObjectInfo object;
+	MeshInfo mesh;
+	TexInfo tex;
+	unsigned int wvOffset;
+	unsigned int texAlpha;
+	unsigned int occluder;
+	unsigned int objectId;
+	Matrix3x4 lastToWorld;
+} Instance;
+
+typedef struct {
+	float3 position;
+	float3 direction;
+	float3 color;
+	float range;
+	float power;
+	unsigned int type;
+	unsigned int pad;
+} Light;
+
+typedef struct {
+	unsigned int tiles_X;
+	unsigned int tiles_Y;
+	unsigned int tile_size;
+	unsigned int slices;
+	float near_z;
+	float log_scale;
+	unsigned int light_first;
+	unsigned int light_count;
+} ClusterInfo;
+
+// state carried by a reflection ray between bounces
+typedef struct {
+	float3 origin;
+	float3 dir;
+	float3 color;
+	float weight;
+	float cone;
+	float spread;
+	unsigned int pad;
+} SecRay;
+
+typedef struct {
+	float bMin[3];
+	unsigned int leftFirst;
+	float bMax[3];
+	unsigned int tCount;
+} BVHNode;
+
 typedef struct {
 	unsigned int aa_lvl;
 	unsigned int aa_dim;
@@ -107,6 +253,10 @@ typedef struct {
 	float3 cam_rgt;
 	float3 cam_up;
 	float3 bl_ray;
+	Matrix3x4 cam_mat;
+	unsigned int ray_count;
+	float jitter_X;
+	float jitter_Y;
 } RenderInfo;
 
 typedef struct {
@@ -130,6 +280,36 @@ typedef struct {
 	};
 } RayIntersect;
 
+#ifdef VIS_BUFFER
+// visibility records only keep what is needed to find the surface again
+typedef struct {
+	float2 bary;
+	float depth;
+	unsigned int instId;
+	unsigned int triId;
+} LayerHit;
+
+typedef struct {
+	__global float2* bary;
+	__global float* depth;
+	__global unsigned int* instId;
+	__global unsigned int* triId;
+	__global RGB32* color;
+	unsigned int stride;
+} LayerSet;
+#else
+typedef RayIntersect LayerHit;
+
+typedef struct {
+	__global float3* point;
+	__global float3* normal;
+	__global float* depth;
+	__global unsigned int* matIndex;
+	__global RGB32* color;
+	unsigned int stride;
+} LayerSet;
+#endif
+
 typedef struct {
 	union {
 		float4 data;
@@ -207,29 +387,15 @@ float3 VectRefl(const float3 v, const float3 norm)
 {
 	return ((norm * -2) * VectDot(norm, v)) + v;
 }
-float3 VectRotX(const float3 v, const float angle)
-{
-	return (float3)(v.x, (v.z*sin(angle)) + (v.y*cos(angle)), (v.z*cos(angle)) - (v.y*sin(angle)));
-}
-float3 VectRotY(const float3 v, const float angle)
-{
-	return (float3)((v.z*sin(angle)) + (v.x*cos(angle)), v.y, (v.z*cos(angle)) - (v.x*sin(angle)));
-}
-float3 VectRotZ(const float3 v, const float angle)
+float3 MatPoint(const Matrix3x4 m, const float3 p)
 {
-	return (float3)((v.x*cos(angle)) - (v.y*sin(angle)), (v.x*sin(angle)) + (v.y*cos(angle)), v.z);
+	return (float3)(dot(m.row[0].xyz, p) + m.row[0].w, 
+					dot(m.row[1].xyz, p) + m.row[1].w, 
+					dot(m.row[2].xyz, p) + m.row[2].w);
 }
-float3 VectRot(const float3 v, const float3 rot)
+float3 MatDir(const Matrix3x4 m, const float3 d)
 {
-	float3 result = VectRotY(v, rot.y);
-	result = VectRotZ(result, rot.z);
-	return VectRotX(result, rot.x);
-}
-float3 VectRev(const float3 v, const float3 rot)
-{
-	float3 result = VectRotY(v, rot.x);
-	result = VectRotZ(result, rot.z);
-	return VectRotX(result, rot.y);
+	return (float3)(dot(m.row[0].xyz, d), dot(m.row[1].xyz, d), dot(m.row[2].xyz, d));
 }
 
 // ------------------------------ //
@@ -358,6 +524,112 @@ float raySphereIntersect(const float3 orig, const float3 dir, const float3 pos,
 	return t0;
 }
 
+float rayNodeIntersect(const float3 orig, const float3 invDir, const BVHNode node, const float maxDist)
+{
+	float3 t0 = ((float3)(node.bMin[0], node.bMin[1], node.bMin[2]) - orig) * invDir;
+	float3 t1 = ((float3)(node.bMax[0], node.bMax[1], node.bMax[2]) - orig) * invDir;
+	float3 tMin = fmin(t0, t1);
+	float3 tMax = fmax(t0, t1);
+	float tNear = max(max(tMin.x, tMin.y), tMin.z);
+	float tFar = min(min(tMax.x, tMax.y), tMax.z);
+
+	if (tFar < tNear || tFar < 0.0f || tNear > maxDist) { return FLT_MAX; }
+
+	return tNear;
+}
+
+// ------------------------------ //
+// ------ LAYER FUNCTIONS ------- //
+// ------------------------------ //
+
+// splits the hit buffer into planes, layer d of a ray is at ray_index + d * stride
+LayerSet HitLayers(__global float* hit_buffer, __global RGB32* cid_buffer, const RenderInfo render_info)
+{
+	unsigned int count = render_info.ray_count * T_DEPTH;
+	LayerSet layers;
+#ifdef VIS_BUFFER
+	layers.bary = (__global float2*)hit_buffer;
+	layers.depth = (__global float*)(layers.bary + count);
+	layers.instId = (__global unsigned int*)(layers.depth + count);
+	layers.triId = layers.instId + count;
+#else
+	layers.point = (__global float3*)hit_buffer;
+	layers.normal = layers.point + count;
+	layers.depth = (__global float*)(layers.normal + count);
+	layers.matIndex = (__global unsigned int*)(layers.depth + count);
+#endif
+	layers.color = cid_buffer;
+	layers.stride = render_info.ray_count;
+	return layers;
+}
+
+float MaxLayerDepth(const LayerSet layers, const unsigned int ray_index, const unsigned char ric, const unsigned char t_depth)
+{
+	// hits behind an opaque layer or a full layer list can be ignored
+	if (ric > 0) {
+		unsigned int li = ray_index + (ric-1) * layers.stride;
+		if (ric == t_depth || layers.color[li].alpha == 255) { return layers.depth[li]; }
+	}
+	return FLT_MAX;
+}
+
+void MoveLayer(const LayerSet layers, const unsigned int src, const unsigned int dst)
+{
+#ifdef VIS_BUFFER
+	layers.bary[dst] = layers.bary[src];
+	layers.instId[dst] = layers.instId[src];
+	layers.triId[dst] = layers.triId[src];
+#else
+	layers.point[dst] = layers.point[src];
+	layers.normal[dst] = layers.normal[src];
+	layers.matIndex[dst] = layers.matIndex[src];
+#endif
+	layers.depth[dst] = layers.depth[src];
+	layers.color[dst] = layers.color[src];
+}
+
+unsigned char ReserveLayer(const LayerSet layers, const unsigned int ray_index, const unsigned char ric, 
+						   const unsigned char t_depth, const float dist)
+{
+	for (unsigned char d = 0; d <= ric; d++) {
+		if (d > 0 && layers.color[ray_index+(d-1)*layers.stride].alpha == 255) { break; }
+		if (d == ric) {
+			if (ric == t_depth) { break; }
+			return d;
+		}
+		if (dist < layers.depth[ray_index+d*layers.stride]) {
+			// move deeper layers back, dropping the last if the list is full
+			for (unsigned char l = min(ric, (unsigned char)(t_depth-1)); l > d; l--) {
+				MoveLayer(layers, ray_index+(l-1)*layers.stride, ray_index+l*layers.stride);
+			}
+			return d;
+		}
+	}
+	return t_depth;
+}
+
+unsigned char InsertLayer(const LayerSet layers, const unsigned int ray_index, const unsigned char ric, 
+						  const unsigned char t_depth, const unsigned char d, const LayerHit hit, const RGB32 color)
+{
+	unsigned int li = ray_index + d * layers.stride;
+#ifdef VIS_BUFFER
+	layers.bary[li] = hit.bary;
+	layers.instId[li] = hit.instId;
+	layers.triId[li] = hit.triId;
+#else
+	layers.point[li] = hit.point;
+	layers.normal[li] = hit.normal;
+	layers.matIndex[li] = hit.matIndex;
+#endif
+	layers.depth[li] = hit.depth;
+	layers.color[li] = color;
+
+	// nothing behind an opaque layer is visible
+	if (color.alpha == 255) { return d+1; }
+
+	return min((unsigned char)(ric+1), t_depth);
+}
+
 // ------------------------------ //
 // ------ INTERP FUNCTIONS ------ //
 // ------------------------------ //
@@ -374,321 +646,1752 @@ float3 InterpolatePoly(Polygon poly, const float2 uv)
 		   (poly.verts[0] * (1.0f - uv.x - uv.y));
 }
 
-float3 InterpolateNorm(__global float3* verts, const unsigned int* vi, const float2 uv, const unsigned char type)
+// positions are quantized inside the cube around the bounding sphere
+float3 MeshVert(VERT_POOL verts, const unsigned int vi, const MeshInfo mesh_info)
+{
+#ifdef MESH_QUANT
+	float3 q = convert_float3(verts[vi].xyz) / 65535.0f;
+	return mesh_info.center + ((q * 2.0f - 1.0f) * mesh_info.radius);
+#else
+	return verts[vi];
+#endif
+}
+
+float3 MeshNorm(VERT_POOL norms, const unsigned int ni)
+{
+#ifdef MESH_QUANT
+	// normals share the vertex buffer but are signed
+	return convert_float3(((__global short4*)norms)[ni].xyz) / 32767.0f;
+#else
+	return norms[ni];
+#endif
+}
+
+// the vertex indexes of each triangle are copied into a stream after the triangles,
+// so intersection tests only read those and the rest is fetched for accepted hits
+__global TRI_FACE* MeshFaces(TRI_POOL mesh, const MeshInfo mesh_info)
+{
+	return (__global TRI_FACE*)(mesh + mesh_info.tCount);
+}
+
+Triangle MeshTri(TRI_POOL mesh, const unsigned int ti)
+{
+#ifdef SHORT_INDEX
+	PackedTri pt = mesh[ti];
+	Triangle tri;
+	for (unsigned int i=0; i<3; i++) {
+		tri.texMap[i] = vload_half2(i, (__global half*)mesh[ti].texMap);
+		tri.vertIndex[i] = pt.vertIndex[i];
+		tri.normIndex[i] = pt.normIndex[i];
+	}
+	tri.texIndex = pt.texIndex;
+	tri.matIndex = pt.matIndex;
+	tri.subIndex = pt.subIndex;
+	tri.type = pt.type;
+	return tri;
+#else
+	return mesh[ti];
+#endif
+}
+
+float3 InterpolateNorm(VERT_POOL norms, const unsigned int* ni, const float2 uv, const unsigned char type)
 {
 	if (type != 1) {
-		return (verts[vi[1]] * uv.x) + (verts[vi[2]] * uv.y) +
-			   (verts[vi[0]] * (1.0f - uv.x - uv.y));
+		return (MeshNorm(norms, ni[1]) * uv.x) + (MeshNorm(norms, ni[2]) * uv.y) +
+			   (MeshNorm(norms, ni[0]) * (1.0f - uv.x - uv.y));
 	} else {
-		return verts[vi[0]];
+		return MeshNorm(norms, ni[0]);
+	}
+}
+
+// pool rectangle of a texture level, each level is half the size of the one before
+TexInfo TexLevel(TexInfo tinfo, const unsigned int level)
+{
+	if (level == 0) { return tinfo; }
+	
+#ifdef TEX_BC
+	// compressed levels follow each other in the block pool
+	unsigned int units = (tinfo.format == TEX_BC3) ? 2 : 1;
+	for (unsigned int l=0; l<level; l++) {
+		tinfo.offset += (((tinfo.width >> l) + 3) / 4) * (((tinfo.height >> l) + 3) / 4) * units;
+	}
+#endif
+	
+	// smaller levels are stacked to the right of the first one
+	tinfo.x += tinfo.width;
+	tinfo.y += tinfo.height - (tinfo.height >> (level-1));
+	tinfo.width >>= level;
+	tinfo.height >>= level;
+	return tinfo;
+}
+
+// width of the ray cone through one sub pixel at a distance along the ray
+float ConeWidth(const RenderInfo render_info, const float3 ray, const float dist)
+{
+	// pixels further from the centre are seen at a smaller angle
+	float cosA = VectDot(ray, render_info.cam_fwd);
+	return dist * render_info.aa_inc * cosA * cosA / render_info.cam_foc;
+}
+
+// picks the texture level whose texels best match the cone footprint on the triangle,
+// the polygon and ray must be in the same space and area_scale brings the polygon to world size
+TexInfo SurfLevel(const Triangle tri, const Polygon poly, const float3 dir, const float area_scale, 
+				  const TexInfo tinfo, const float cone_width)
+{
+	if (tinfo.levels <= 1) { return tinfo; }
+	
+	float2 t1 = tri.texMap[1] - tri.texMap[0];
+	float2 t2 = tri.texMap[2] - tri.texMap[0];
+	float texArea = fabs(t1.x*t2.y - t1.y*t2.x) * tinfo.width * tinfo.height;
+	float3 faceVect = VectCross(poly.verts[1] - poly.verts[0], poly.verts[2] - poly.verts[0]);
+	float polyArea = VectMag(faceVect);
+	
+	if (texArea <= 0.0f || polyArea <= 0.0f) { return tinfo; }
+	
+	// surfaces seen at a grazing angle stretch the footprint
+	float cosN = max(fabs(VectDot(faceVect / polyArea, VectNorm(dir))), 0.01f);
+	float lod = 0.5f * log2(texArea / (polyArea * area_scale)) + log2(cone_width / cosN);
+	
+	return TexLevel(tinfo, clamp(lod + 0.5f, 0.0f, (float)(tinfo.levels-1)));
+}
+
+int4 Color565(const unsigned int c)
+{
+	return (int4)(((c >> 11) & 31) * 255 / 31, ((c >> 5) & 63) * 255 / 63, (c & 31) * 255 / 31, 255);
+}
+
+// palettes must match Compress.h
+uchar4 DecodeTexel(__global uint2* blocks, const TexInfo tinfo, const unsigned int iX, const unsigned int iY)
+{
+	unsigned int units = (tinfo.format == TEX_BC3) ? 2 : 1;
+	unsigned int bi = tinfo.offset + (((iY / 4) * ((tinfo.width + 3) / 4)) + (iX / 4)) * units;
+	unsigned int ti = ((iY & 3) * 4) + (iX & 3);
+	
+	// color end points and 2 bit indexes come last in both formats
+	uint2 cb = blocks[bi + units - 1];
+	unsigned int c0 = cb.x & 0xFFFF;
+	unsigned int c1 = cb.x >> 16;
+	unsigned int ci = (c0 == c1) ? 0 : (cb.y >> (ti * 2)) & 3;
+	int4 e0 = Color565(c0);
+	int4 e1 = Color565(c1);
+	int4 color = (ci == 0) ? e0 : (ci == 1) ? e1 : (ci == 2) ? (2 * e0 + e1) / 3 : (e0 + 2 * e1) / 3;
+	
+	if (tinfo.format == TEX_BC3) {
+		uint2 ab = blocks[bi];
+		int a0 = ab.x & 0xFF;
+		int a1 = (ab.x >> 8) & 0xFF;
+		ulong bits = ((ulong)ab.x >> 16) | ((ulong)ab.y << 16);
+		int ai = (a0 == a1) ? 0 : (bits >> (ti * 3)) & 7;
+		color.w = (ai == 0) ? a0 : (ai == 1) ? a1 : ((8 - ai) * a0 + (ai - 1) * a1) / 7;
 	}
+	
+	return convert_uchar4_sat(color);
 }
 
-RGB32 InterpolateSurf(__global RGB32* surf, __global Material* mats, 
-					 const Triangle tri, const float2 uv, const SurfInfo sinfo)
+RGB32 InterpolateSurf(TEX_POOL surf, __global Material* mats, 
+					 const Triangle tri, const float2 uv, const TexInfo tinfo)
 {
-	float2 texCoords = InterpolateTexmap(tri.texMap[0], tri.texMap[1], tri.texMap[2], uv);
-	unsigned int iX = texCoords.x * (sinfo.width-1);
-	unsigned int iY = texCoords.y * (sinfo.height-1);
-	RGB32 pntColor = surf[iX + (iY * sinfo.width)];
-	pntColor.alpha *= mats[tri.matIndex].transparency;
+	float2 texCoords = clamp(InterpolateTexmap(tri.texMap[0], tri.texMap[1], tri.texMap[2], uv), 0.0f, 1.0f);
+	
+#ifdef TEX_BC
+	// nearest texel since filtering would decode four blocks
+	uchar4 texel = DecodeTexel(surf, tinfo, texCoords.x * (tinfo.width-1), texCoords.y * (tinfo.height-1));
+#else
+	// stay between the edge texel centres so filtering never reaches the next level
+	float tX = tinfo.x + 0.5f + texCoords.x * (tinfo.width-1);
+	float tY = tinfo.y + 0.5f + texCoords.y * (tinfo.height-1);
+	uchar4 texel = convert_uchar4_sat_rte(read_imagef(surf, tex_sampler, (float4)(tX, tY, tinfo.layer, 0.0f)) * 255.0f);
+#endif
+	
+	RGB32 pntColor;
+	pntColor.red = texel.x;
+	pntColor.green = texel.y;
+	pntColor.blue = texel.z;
+	pntColor.alpha = texel.w * mats[tri.matIndex].transparency;
 	return pntColor;
 }
 
-Polygon TriRelWorld(__global float3* verts, const Triangle tri, const ObjectInfo object_info)
+unsigned char SurfAlpha(TEX_POOL surf, __global Material* mats, const Triangle tri, 
+						const float2 uv, const TexInfo tinfo, const bool tex_alpha)
+{
+	// textures without translucent texels don't need to be read at all
+	if (tex_alpha) { return InterpolateSurf(surf, mats, tri, uv, tinfo).alpha; }
+	return 255 * mats[tri.matIndex].transparency;
+}
+
+Polygon FaceRelObject(__global float3* verts, const TRI_FACE face)
+{
+	Polygon poly;
+	poly.verts[0] = verts[face.x];
+	poly.verts[1] = verts[face.y];
+	poly.verts[2] = verts[face.z];
+	return poly;
+}
+
+Polygon FaceRelMesh(VERT_POOL verts, const TRI_FACE face, const MeshInfo mesh_info)
+{
+	Polygon poly;
+	poly.verts[0] = MeshVert(verts, face.x, mesh_info);
+	poly.verts[1] = MeshVert(verts, face.y, mesh_info);
+	poly.verts[2] = MeshVert(verts, face.z, mesh_info);
+	return poly;
+}
+
+Polygon TriRelMesh(VERT_POOL verts, const Triangle tri, const MeshInfo mesh_info)
 {
 	Polygon poly;
-	poly.verts[0] = VectRot((verts[tri.vertIndex[0]] - object_info.center) * 
-					object_info.scale, object_info.orientation) + object_info.position;
-	poly.verts[1] = VectRot((verts[tri.vertIndex[1]] - object_info.center) * 
-					object_info.scale, object_info.orientation) + object_info.position;
-	poly.verts[2] = VectRot((verts[tri.vertIndex[2]] - object_info.center) * 
-					object_info.scale, object_info.orientation) + object_info.position;
+	poly.verts[0] = MeshVert(verts, tri.vertIndex[0], mesh_info);
+	poly.verts[1] = MeshVert(verts, tri.vertIndex[1], mesh_info);
+	poly.verts[2] = MeshVert(verts, tri.vertIndex[2], mesh_info);
 	return poly;
 }
 
+float3 VertRelWorld(const float3 vert, const ObjectInfo object_info)
+{
+	return MatPoint(object_info.toWorld, vert);
+}
+
 // ------------------------------ //
-// ------ KERNEL FUNCTIONS ------ //
+// ------ TRACE FUNCTIONS ------- //
 // ------------------------------ //
 
-__kernel void ComputeStage0x1(__global PRay* ray_buffer, const RenderInfo render_info)
+unsigned char InsertSphereHit(const LayerSet layers,
+							  const ObjectInfo object_info, const RenderInfo render_info, const float3 ray,
+							  const float sDist, const unsigned int inst_id, const unsigned int ray_index, const unsigned char ric)
 {
-    unsigned int pix_X = get_global_id(0);
-	unsigned int pix_Y = get_global_id(1);
-	unsigned int pix_index = (pix_Y * render_info.pixels_X) + pix_X;
-	PRay primaryRay;
+	unsigned char d = ReserveLayer(layers, ray_index, ric, render_info.t_depth, sDist);
 	
-	primaryRay.ray = render_info.bl_ray + (render_info.cam_rgt * pix_X);
-	primaryRay.ray = VectNorm(primaryRay.ray + (render_info.cam_up * pix_Y));
-	primaryRay.intersects = 0;
-	ray_buffer[pix_index] = primaryRay;
+	if (d == render_info.t_depth) { return ric; }
+	
+	LayerHit tmpRid;
+#ifdef VIS_BUFFER
+	tmpRid.bary = (float2)(0.0f, 0.0f);
+	tmpRid.instId = inst_id;
+	tmpRid.triId = 0;
+#else
+	float3 pntVect = render_info.cam_pos + (ray * sDist);
+	float3 nrmVect = VectNorm(pntVect - object_info.position);
+	tmpRid.point = pntVect;
+	tmpRid.normal = nrmVect;
+	// analytical spheres are only used for light objects
+	tmpRid.matIndex = LIGHT_MAT;
+#endif
+	tmpRid.depth = sDist;
+	
+	return InsertLayer(layers, ray_index, ric, render_info.t_depth, d, tmpRid, object_info.color);
 }
 
-__kernel void ComputeStage0xN(__global PRay* ray_buffer, const RenderInfo render_info)
+unsigned char InsertTriHit(const LayerSet layers,
+						   __global Material* mat_set, VERT_POOL norms, TEX_POOL texture,
+						   const Triangle tri, const RTResult rtr, const float3 pntVect, const TexInfo tex_info,
+						   const Matrix3x4 to_world,
+						   const unsigned int inst_id, const unsigned int tri_id, const bool tex_alpha,
+						   const unsigned int ray_index, const unsigned char ric, const RenderInfo render_info)
 {
-    unsigned int pix_X = get_global_id(0);
-	unsigned int pix_Y = get_global_id(1);
-    float max_X = (float)pix_X + 1.0f;
-	float max_Y = (float)pix_Y + 1.0f;
-	unsigned int pix_index = (pix_Y * render_info.pixels_X) + pix_X;
-	unsigned int ray_index = pix_index * render_info.aa_lvl;
-	PRay primaryRay;
+	float3 socPnt = MatPoint(render_info.cam_mat, pntVect);
 	
-	for (float yr=pix_Y+render_info.aa_div; yr < max_Y; yr += render_info.aa_inc) {
-		for (float xr=pix_X+render_info.aa_div; xr < max_X; xr += render_info.aa_inc) {
-		
-			primaryRay.ray = render_info.bl_ray + (render_info.cam_rgt * xr);
-			primaryRay.ray = VectNorm(primaryRay.ray + (render_info.cam_up * yr));
-			primaryRay.intersects = 0;
-			ray_buffer[ray_index] = primaryRay;
-			ray_index++;
-		}
-	}
+	if (socPnt.z <= 0.0f) { return ric; }
+	
+	unsigned char d = ReserveLayer(layers, ray_index, ric, render_info.t_depth, rtr.dist);
+	
+	if (d == render_info.t_depth) { return ric; }
+	
+	LayerHit tmpRid;
+#ifdef VIS_BUFFER
+	// only the opacity is needed to sort layers, ComputeResolve fetches the color later
+	RGB32 pntColor;
+	pntColor.alpha = SurfAlpha(texture, mat_set, tri, rtr.uv, tex_info, tex_alpha);
+	tmpRid.bary = rtr.uv;
+	tmpRid.instId = inst_id;
+	tmpRid.triId = tri_id;
+#else
+	RGB32 pntColor = InterpolateSurf(texture, mat_set, tri, rtr.uv, tex_info);
+	float3 nrmVect = VectNorm(MatDir(to_world, InterpolateNorm(norms, &(tri.normIndex[0]), rtr.uv, tri.type)));
+	tmpRid.point = pntVect;
+	tmpRid.normal = nrmVect;
+	tmpRid.matIndex = tri.matIndex;
+#endif
+	tmpRid.depth = rtr.dist;
+	
+	return InsertLayer(layers, ray_index, ric, render_info.t_depth, d, tmpRid, pntColor);
 }
 
-__kernel void ComputeStage1S(__global PRay* ray_buffer, __global RayIntersect* rid_buffer,
-__global RGB32* cid_buffer, const ObjectInfo object_info, const RenderInfo render_info)
+unsigned char TraceMesh(const LayerSet layers, __global Material* mat_set, 
+						VERT_POOL verts, __global float3* world_verts, TRI_POOL mesh, __global BVHNode* bvh, 
+						__global unsigned int* bvh_index, TEX_POOL texture, const ObjectInfo object_info,
+						const MeshInfo mesh_info, const TexInfo tex_info, const RenderInfo render_info,
+						const float3 ray, const float minDist, const unsigned int inst_id, const bool tex_alpha,
+						const unsigned int ray_index, unsigned char ric)
 {
-    unsigned int pix_X = get_global_id(0);
-	unsigned int pix_Y = get_global_id(1);
-	unsigned int pix_index = (pix_Y * render_info.pixels_X) + pix_X;
-	unsigned int ray_index = pix_index * render_info.aa_lvl;
+	bool showBF = BackFaces(object_info);
+	float maxDist = MaxLayerDepth(layers, ray_index, ric, render_info.t_depth);
 	
-	for (unsigned int r=render_info.aa_lvl; r-- > 0; ray_index++) {
+	if (mesh_info.tCount == 0) { return ric; }
 	
-		unsigned int rid_index = ray_index * render_info.t_depth;
-		PRay primRay = ray_buffer[ray_index];
-		unsigned char ric = primRay.intersects;
-		
-		float sDist = raySphereIntersect(render_info.cam_pos,
-					  primRay.ray, object_info.position, object_info.radius2);
+	__global TRI_FACE* faces = MeshFaces(mesh, mesh_info);
+	
+	// skip the mesh if the ray misses its bounding sphere
+	if (VectSqrd(object_info.position, render_info.cam_pos) >= object_info.radius2) {
+		float sDist = raySphereIntersect(render_info.cam_pos, ray, object_info.position, object_info.radius2);
+		if (sDist <= 0.0f || sDist > maxDist) { return ric; }
+	}
+	
+#ifdef MESH_BVH
+	// the hierarchy is in object space so the ray is moved there instead of the mesh
+	float3 objOrig = MatPoint(object_info.toObject, render_info.cam_pos);
+	float3 objDir = MatDir(object_info.toObject, ray);
+	float3 invDir = 1.0f / objDir;
+	unsigned int stack[BVH_STACK_SIZE];
+	unsigned int sp = 0;
+	unsigned int ni = 0;
+	
+	while (true) {
+	
+		BVHNode node = bvh[ni];
 		
-		if (sDist > 0.0f) {
+		if (node.tCount > 0) {
 		
-			if (ric >= render_info.t_depth) {
-				if (sDist > rid_buffer[rid_index+ric-1].depth) {
-					continue;
-				}			
-			}	
-			
-			unsigned char d = 0;
+			for (unsigned int li=0; li<node.tCount; li++) {
 			
-			for (unsigned int ii=rid_index; d<=ric; ii++) {
-				if (d == ric) {
+				unsigned int ti = bvh_index[node.leftFirst+li];
+				Polygon poly = FaceRelMesh(verts, faces[ti], mesh_info);
 				
-					if (ric == render_info.t_depth) { break; }
-
-					RayIntersect tmpRid;
-					float3 pntVect = render_info.cam_pos + (primRay.ray * sDist);
-					float3 nrmVect = VectNorm(pntVect - object_info.position);
-					tmpRid.point = pntVect;
-					tmpRid.normal = nrmVect;
-					tmpRid.depth = sDist;
-					tmpRid.matIndex = 0;
-					cid_buffer[ii] = object_info.color;
-					rid_buffer[ii] = tmpRid;
-					ray_buffer[ray_index].intersects++;
-					break;
-				}
-				
-				if (sDist < rid_buffer[ii].depth) {	
+				// distances along the object space ray match world space distances
+				RTResult rtr = primaryRayTriIntersect(objOrig, objDir, poly, showBF);
 				
-					while (d < ric) {
-						rid_buffer[rid_index+d+1] = rid_buffer[rid_index+d];
-						d++;
-					}
-					
-					RayIntersect tmpRid;
-					float3 pntVect = render_info.cam_pos + (primRay.ray * sDist);
-					float3 nrmVect = VectNorm(pntVect - object_info.position);
-					tmpRid.point = pntVect;
-					tmpRid.normal = nrmVect;
-					tmpRid.depth = sDist;
-					tmpRid.matIndex = 0;
-					cid_buffer[ii] = object_info.color;
-					rid_buffer[ii] = tmpRid;
-					ray_buffer[ray_index].intersects++;
-					break;
+				if (rtr.hit && rtr.dist > minDist && rtr.dist < maxDist) {
+					Triangle tri = MeshTri(mesh, ti);
+					float3 pntVect = render_info.cam_pos + (ray * rtr.dist);
+					TexInfo level = SurfLevel(tri, poly, objDir, object_info.scale * object_info.scale, 
+									tex_info, ConeWidth(render_info, ray, rtr.dist));
+					ric = InsertTriHit(layers, mat_set, verts + mesh_info.vCount, texture, tri, rtr, pntVect, 
+						  level, object_info.toWorld, inst_id, ti, tex_alpha, ray_index, ric, render_info);
+					maxDist = MaxLayerDepth(layers, ray_index, ric, render_info.t_depth);
 				}
-				d++;
 			}
+			
+			if (sp == 0) { break; }
+			ni = stack[--sp];
+			continue;
+		}
+		
+		// visit the nearest child first and save the other for later
+		unsigned int c1 = node.leftFirst;
+		unsigned int c2 = node.leftFirst + 1;
+		float d1 = rayNodeIntersect(objOrig, invDir, bvh[c1], maxDist);
+		float d2 = rayNodeIntersect(objOrig, invDir, bvh[c2], maxDist);
+		
+		if (d1 > d2) {
+			float td = d1; d1 = d2; d2 = td;
+			unsigned int tc = c1; c1 = c2; c2 = tc;
+		}
+		
+		if (d1 == FLT_MAX) {
+			if (sp == 0) { break; }
+			ni = stack[--sp];
+		} else {
+			ni = c1;
+			if (d2 != FLT_MAX) { stack[sp++] = c2; }
+		}
+	}
+#else
+	for (unsigned int ti=0; ti<mesh_info.tCount; ti++) {
+	
+		// vertices were moved into world space by ComputeStage1V
+		Polygon poly = FaceRelObject(world_verts, faces[ti]);
+		
+		RTResult rtr = primaryRayTriIntersect(render_info.cam_pos, ray, poly, showBF);
+		
+		if (rtr.hit && rtr.dist > minDist && rtr.dist < maxDist) {
+			Triangle tri = MeshTri(mesh, ti);
+			float3 pntVect = InterpolatePoly(poly, rtr.uv);
+			TexInfo level = SurfLevel(tri, poly, ray, 1.0f, tex_info, ConeWidth(render_info, ray, rtr.dist));
+			ric = InsertTriHit(layers, mat_set, verts + mesh_info.vCount, texture, tri, rtr, pntVect, 
+				  level, object_info.toWorld, inst_id, ti, tex_alpha, ray_index, ric, render_info);
+			maxDist = MaxLayerDepth(layers, ray_index, ric, render_info.t_depth);
 		}
 	}
+#endif
+
+	return ric;
 }
 
-__kernel void ComputeStage1T(__global PRay* ray_buffer, __global RayIntersect* rid_buffer,
-__global RGB32* cid_buffer, __global Material* mat_set, __global float3* verts, __global Triangle* mesh,
-__global RGB32* texture, __global float3* norm_map, const ObjectInfo object_info,
-const MeshInfo mesh_info, const SurfInfo surf_info, const RenderInfo render_info)
+unsigned char TraceInstance(const LayerSet layers, 
+							__global Material* mat_set, VERT_POOL vert_pool, __global float3* wvert_pool, TRI_POOL tri_pool,
+							__global BVHNode* bvh_pool, __global unsigned int* index_pool, TEX_POOL tex_pool,
+							__global Instance* instances, const unsigned int inst_id, const RenderInfo render_info, 
+							const float3 ray, const float minDist, const unsigned int ray_index, const unsigned char ric)
 {
-	__local bool insideBS;
-	__local float sDist;
-    unsigned int pix_X = get_global_id(0);
-	unsigned int pix_Y = get_global_id(1);
-	unsigned int pix_index = (pix_Y * render_info.pixels_X) + pix_X;
-	unsigned int ray_index = pix_index * render_info.aa_lvl;
-	sDist = VectSqrd(object_info.position, render_info.cam_pos);
-	insideBS = sDist < object_info.radius2;
+	__global Instance* inst = &instances[inst_id];
 	
-	for (unsigned int r=render_info.aa_lvl; r-- > 0; ray_index++) {
-
-		unsigned int rid_index = ray_index * render_info.t_depth;	
-		PRay primRay = ray_buffer[ray_index];
-		unsigned char ric = primRay.intersects;
-
-		if (!insideBS) {
-			sDist = raySphereIntersect(render_info.cam_pos, primRay.ray, 
-					object_info.position, object_info.radius2);
+	// analytical spheres have no mesh
+	if (inst->object.type == -1) {
+	
+		float sDist = raySphereIntersect(render_info.cam_pos, ray, inst->object.position, inst->object.radius2);
+		
+		if (sDist <= minDist || sDist >= MaxLayerDepth(layers, 
+			ray_index, ric, render_info.t_depth)) { return ric; }
 			
-			if (sDist > 0.0f) {
-				if (ric == render_info.t_depth) {
-					if (sDist > rid_buffer[rid_index+ric-1].depth) {
-						continue;
-					}			
+		return InsertSphereHit(layers, inst->object, render_info, ray, sDist, inst_id, ray_index, ric);
+	}
+	
+	// each mesh lives in its own range of the shared geometry buffers
+	return TraceMesh(layers, mat_set, vert_pool + inst->mesh.vOffset,
+					 wvert_pool + inst->wvOffset, tri_pool + inst->mesh.tOffset, bvh_pool + inst->mesh.bOffset, 
+					 index_pool + inst->mesh.iOffset, tex_pool, inst->object,
+					 inst->mesh, inst->tex, render_info, ray, minDist, inst_id, inst->texAlpha != 0, ray_index, ric);
+}
+
+// walks a hierarchy built over sphere objects, which need nothing but their object info
+unsigned char TraceSpheres(const LayerSet layers, __global ObjectInfo* spheres, __global BVHNode* sph_bvh, 
+						   __global unsigned int* sph_index, const RenderInfo render_info, const float3 ray,
+						   const unsigned int ray_index, unsigned char ric)
+{
+	float maxDist = MaxLayerDepth(layers, ray_index, ric, render_info.t_depth);
+	float3 invDir = 1.0f / ray;
+	unsigned int stack[BVH_STACK_SIZE];
+	unsigned int sp = 0;
+	unsigned int ni = 0;
+	
+	while (true) {
+	
+		BVHNode node = sph_bvh[ni];
+		
+		if (node.tCount > 0) {
+		
+			for (unsigned int li=0; li<node.tCount; li++) {
+				__global ObjectInfo* sph = &spheres[sph_index[node.leftFirst+li]];
+				float sDist = raySphereIntersect(render_info.cam_pos, ray, sph->position, sph->radius2);
+				if (sDist > 0.0f && sDist < maxDist) {
+					ric = InsertSphereHit(layers, *sph, render_info, ray, sDist, sph->index, ray_index, ric);
+					maxDist = MaxLayerDepth(layers, ray_index, ric, render_info.t_depth);
 				}
-			} else {
-				continue;
 			}
+			
+			if (sp == 0) { break; }
+			ni = stack[--sp];
+			continue;
 		}
 		
-		for (unsigned int ti=0; ti<mesh_info.tCount; ti++) {
+		unsigned int c1 = node.leftFirst;
+		unsigned int c2 = node.leftFirst + 1;
+		float d1 = rayNodeIntersect(render_info.cam_pos, invDir, sph_bvh[c1], maxDist);
+		float d2 = rayNodeIntersect(render_info.cam_pos, invDir, sph_bvh[c2], maxDist);
 		
-			Triangle tri = mesh[ti];
-			Polygon poly = TriRelWorld(verts, tri, object_info);
-			
-			RTResult rtr = primaryRayTriIntersect(render_info.cam_pos, 
-						   primRay.ray, poly, object_info.boolBits & m_showBF);
-			
-			if (rtr.hit) {
-			
-				float3 pntVect = InterpolatePoly(poly, rtr.uv);
-				float3 socPnt = VectRot(pntVect - render_info.cam_pos, render_info.cam_ori);
-	
-				if (socPnt.z > 0.0f) {
-				
-					unsigned char d = 0;
-					
-					for (unsigned int ii=rid_index; d<=ric; ii++) {
-						if (d == ric) {
-						
-							if (d > 0 && cid_buffer[ii-1].alpha == 255) { break; }
-							if (ric == render_info.t_depth) { break; }
-							
-							RayIntersect tmpRid;	
-							RGB32 pntColor = InterpolateSurf(texture, mat_set, tri, rtr.uv, surf_info);
-							float3 nrmVect = InterpolateNorm(verts, &(tri.normIndex[0]), rtr.uv, tri.type);
-							tmpRid.point = pntVect;
-							tmpRid.normal = nrmVect;
-							tmpRid.depth = rtr.dist;
-							tmpRid.matIndex = tri.matIndex;
-							cid_buffer[ii] = pntColor;	
-							rid_buffer[ii] = tmpRid;
-							
-							if (pntColor.alpha == 255) {
-								ric = d+1;
-							} else {
-								ric++;
-							}
-							break;
-						}
-						
-						if (rtr.dist < rid_buffer[ii].depth) {
-						
-							if (d > 0 && cid_buffer[ii-1].alpha == 255) { break; }
-							if (ric == render_info.t_depth) { ric--; }
-							
-							for (unsigned int l = 0; d++ < ric; l++) {
-								rid_buffer[rid_index+ric-l-1] = rid_buffer[rid_index+ric-l];
-								cid_buffer[rid_index+ric-l-1] = cid_buffer[rid_index+ric-l];
-							}
-							
-							RayIntersect tmpRid;
-							RGB32 pntColor = InterpolateSurf(texture, mat_set, tri, rtr.uv, surf_info);
-							float3 nrmVect = InterpolateNorm(verts, &(tri.normIndex[0]), rtr.uv, tri.type);
-							tmpRid.point = pntVect;
-							tmpRid.normal = nrmVect;
-							tmpRid.depth = rtr.dist;
-							tmpRid.matIndex = tri.matIndex;
-							cid_buffer[ii] = pntColor;
-							rid_buffer[ii] = tmpRid;
-							
-							if (pntColor.alpha == 255) {
-								ric = d+1;
-							} else {
-								ric++;
-							}
-							break;
-						}
-						d++;
-					}
-					if (primRay.intersects != ric) {
-						ray_buffer[ray_index].intersects = ric;
-					}
-				}
-			}
+		if (d1 > d2) {
+			float td = d1; d1 = d2; d2 = td;
+			unsigned int tc = c1; c1 = c2; c2 = tc;
+		}
+		
+		if (d1 == FLT_MAX) {
+			if (sp == 0) { break; }
+			ni = stack[--sp];
+		} else {
+			ni = c1;
+			if (d2 != FLT_MAX) { stack[sp++] = c2; }
 		}
 	}
+	
+	return ric;
 }
 
-__kernel void ComputeStage2x4(__global PRay* ray_buffer, __global RGB32_x4* cid_buffer,
-write_only image2d_t pix_buffer, const RenderInfo render_info)
+unsigned char TraceScene(const LayerSet layers, 
+						 __global Material* mat_set, VERT_POOL vert_pool, __global float3* wvert_pool, 
+						 TRI_POOL tri_pool, __global BVHNode* bvh_pool, __global unsigned int* index_pool, 
+						 TEX_POOL tex_pool, __global Instance* instances, __global BVHNode* tlas, 
+						 __global unsigned int* tlas_index, const RenderInfo render_info, const float3 ray,
+						 const float minDist, const unsigned int ray_index, unsigned char ric)
 {
-    unsigned int pix_X = get_global_id(0);
-	unsigned int pix_Y = get_global_id(1);
-	unsigned int pix_index = (pix_Y * render_info.pixels_X) + pix_X;
-	unsigned int ray_index = pix_index * render_info.aa_lvl;
-	float3 sumColor = (float3)(0.0f,0.0f,0.0f);
-	unsigned char ric;
-	RGB32 itpColor;
-		
-	for (unsigned int r=render_info.aa_lvl; r-- > 0; ray_index++) {
+	float maxDist = MaxLayerDepth(layers, ray_index, ric, render_info.t_depth);
+	float3 invDir = 1.0f / ray;
+	unsigned int stack[BVH_STACK_SIZE];
+	unsigned int sp = 0;
+	unsigned int ni = 0;
 	
-		ric = ray_buffer[ray_index].intersects;
-		RGB32_x4 ray_cid = cid_buffer[ray_index];
+	// walk the top level hierarchy built over the visible objects
+	while (true) {
+	
+		BVHNode node = tlas[ni];
 		
-		if (ric > 1) {
+		if (node.tCount > 0) {
 		
-			itpColor = ray_cid.colors[ric-1];
-			
-			for (int ii=ric-2; ii > -1; ii--) {
-				itpColor = AlphaBlend(itpColor, ray_cid.colors[ii]);
+			for (unsigned int li=0; li<node.tCount; li++) {
+				ric = TraceInstance(layers, mat_set, vert_pool, wvert_pool, tri_pool, bvh_pool, index_pool, 
+					  tex_pool, instances, tlas_index[node.leftFirst+li], render_info, ray, minDist, ray_index, ric);
 			}
-
-			sumColor.x += itpColor.red;
-			sumColor.y += itpColor.green;
-			sumColor.z += itpColor.blue;
 			
-		} else if (ric == 1) {
+			maxDist = MaxLayerDepth(layers, ray_index, ric, render_info.t_depth);
+			
+			if (sp == 0) { break; }
+			ni = stack[--sp];
+			continue;
+		}
 		
-			itpColor = ray_cid.colors[0];
-
-			sumColor.x += itpColor.red;
-			sumColor.y += itpColor.green;
-			sumColor.z += itpColor.blue;
+		unsigned int c1 = node.leftFirst;
+		unsigned int c2 = node.leftFirst + 1;
+		float d1 = rayNodeIntersect(render_info.cam_pos, invDir, tlas[c1], maxDist);
+		float d2 = rayNodeIntersect(render_info.cam_pos, invDir, tlas[c2], maxDist);
+		
+		if (d1 > d2) {
+			float td = d1; d1 = d2; d2 = td;
+			unsigned int tc = c1; c1 = c2; c2 = tc;
+		}
+		
+		if (d1 == FLT_MAX) {
+			if (sp == 0) { break; }
+			ni = stack[--sp];
+		} else {
+			ni = c1;
+			if (d2 != FLT_MAX) { stack[sp++] = c2; }
 		}
 	}
 	
-	write_imagef(pix_buffer, (int2)(pix_X, pix_Y), VectToColor(sumColor * render_info.aa_div));
+	return ric;
 }
 
-__kernel void ComputeStage2x1(__global PRay* ray_buffer, __global RGB32* cid_buffer,
-write_only image2d_t pix_buffer, const RenderInfo render_info)
+void TracePixelMesh(__global PRay* ray_buffer, const LayerSet layers, 
+					__global Material* mat_set, VERT_POOL verts, __global float3* world_verts, 
+					TRI_POOL mesh, __global BVHNode* bvh, __global unsigned int* bvh_index, 
+					TEX_POOL texture, const ObjectInfo object_info, const MeshInfo mesh_info, 
+					const TexInfo tex_info, const RenderInfo render_info, const unsigned int pix_index)
 {
-    unsigned int pix_X = get_global_id(0);
-	unsigned int pix_Y = get_global_id(1);
-	unsigned int pix_index = (pix_Y * render_info.pixels_X) + pix_X;
-	unsigned int ray_index = pix_index * render_info.aa_lvl;
-	float3 sumColor = (float3)(0.0f,0.0f,0.0f);
-	RGB32 itpColor;
-		
-	for (unsigned int r=render_info.aa_lvl; r-- > 0; ray_index++) {
+	unsigned int ray_index = pix_index * AA_LVL;
 	
-		itpColor = cid_buffer[ray_index];
+	for (unsigned int r=AA_LVL; r-- > 0; ray_index++) {
+
+		PRay primRay = ray_buffer[ray_index];
+		
+		unsigned char ric = TraceMesh(layers, mat_set, verts, world_verts, mesh, bvh, bvh_index, texture, 
+							object_info, mesh_info, tex_info, render_info, primRay.ray, 0.0f, object_info.index, true, 
+							ray_index, primRay.intersects);
+
+		if (primRay.intersects != ric) {
+			ray_buffer[ray_index].intersects = ric;
+		}
+	}
+}
 
-		sumColor.x += itpColor.red;
-		sumColor.y += itpColor.green;
-		sumColor.z += itpColor.blue;
+// all rays in the work group test the same chunk of triangles from local memory
+void TracePixelTiled(__global PRay* ray_buffer, const LayerSet layers, 
+					 __global Material* mat_set, VERT_POOL verts, __global float3* world_verts, 
+					 TRI_POOL mesh, TEX_POOL texture, const ObjectInfo object_info, 
+					 const MeshInfo mesh_info, const TexInfo tex_info, const RenderInfo render_info, 
+					 __local Polygon* tile_polys, const unsigned int pix_index)
+{
+	unsigned int lid = get_local_id(0) + (get_local_id(1) * get_local_size(0));
+	unsigned int lsize = get_local_size(0) * get_local_size(1);
+	bool showBF = BackFaces(object_info);
+	__global TRI_FACE* faces = MeshFaces(mesh, mesh_info);
+	
+	for (unsigned int tf=0; tf<mesh_info.tCount; tf+=TRI_TILE_SIZE) {
+	
+		unsigned int tc = min((unsigned int)TRI_TILE_SIZE, mesh_info.tCount - tf);
+		
+		// vertices were moved into world space by ComputeStage1V
+		for (unsigned int li=lid; li<tc; li+=lsize) {
+			tile_polys[li] = FaceRelObject(world_verts, faces[tf+li]);
+		}
+		
+		barrier(CLK_LOCAL_MEM_FENCE);
+		
+		unsigned int ray_index = pix_index * AA_LVL;
+		
+		for (unsigned int r=AA_LVL; r-- > 0; ray_index++) {
+		
+			PRay primRay = ray_buffer[ray_index];
+			unsigned char ric = primRay.intersects;
+			float maxDist = MaxLayerDepth(layers, ray_index, ric, render_info.t_depth);
+			
+			for (unsigned int ti=0; ti<tc; ti++) {
+			
+				Polygon poly = tile_polys[ti];
+				RTResult rtr = primaryRayTriIntersect(render_info.cam_pos, primRay.ray, poly, showBF);
+				
+				if (rtr.hit && rtr.dist > 0.0f && rtr.dist < maxDist) {
+					float3 pntVect = InterpolatePoly(poly, rtr.uv);
+					Triangle tri = MeshTri(mesh, tf+ti);
+					TexInfo level = SurfLevel(tri, poly, primRay.ray, 1.0f, tex_info, ConeWidth(render_info, primRay.ray, rtr.dist));
+					ric = InsertTriHit(layers, mat_set, verts + mesh_info.vCount, texture, tri, rtr, pntVect, 
+						  level, object_info.toWorld, object_info.index, tf+ti, true, ray_index, ric, render_info);
+					maxDist = MaxLayerDepth(layers, ray_index, ric, render_info.t_depth);
+				}
+			}
+			
+			if (primRay.intersects != ric) {
+				ray_buffer[ray_index].intersects = ric;
+			}
+		}
+		
+		// wait for every ray before the chunk is replaced
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+}
+
+void TracePixelScene(__global PRay* ray_buffer, const LayerSet layers, 
+					 __global Material* mat_set, VERT_POOL vert_pool, __global float3* wvert_pool, 
+					 TRI_POOL tri_pool, __global BVHNode* bvh_pool, __global unsigned int* index_pool, 
+					 TEX_POOL tex_pool, __global Instance* instances, __global BVHNode* tlas, 
+					 __global unsigned int* tlas_index, const RenderInfo render_info, const unsigned int pix_index)
+{
+	unsigned int ray_index = pix_index * AA_LVL;
+	
+	for (unsigned int r=AA_LVL; r-- > 0; ray_index++) {
+
+		PRay primRay = ray_buffer[ray_index];
+		
+		unsigned char ric = TraceScene(layers, mat_set, vert_pool, wvert_pool, tri_pool, bvh_pool, 
+							index_pool, tex_pool, instances, tlas, tlas_index, render_info, primRay.ray, 
+							0.0f, ray_index, primRay.intersects);
+
+		if (primRay.intersects != ric) {
+			ray_buffer[ray_index].intersects = ric;
+		}
+	}
+}
+
+// hands the next batch of pixels to a persistent work group
+unsigned int NextPixelBatch(volatile __global unsigned int* work_counter, __local unsigned int* batch)
+{
+	if (get_local_id(0) == 0) { *batch = atomic_inc(work_counter); }
+	barrier(CLK_LOCAL_MEM_FENCE);
+	unsigned int first = *batch * get_local_size(0);
+	barrier(CLK_LOCAL_MEM_FENCE);
+	return first;
+}
+
+// ------------------------------ //
+// ------ LIGHT FUNCTIONS ------- //
+// ------------------------------ //
+
+// shadow rays only need to know if anything is in the way, so every search stops at the first hit
+bool OccludedMesh(VERT_POOL verts, __global float3* world_verts, TRI_POOL mesh, 
+				  __global BVHNode* bvh, __global unsigned int* bvh_index, const ObjectInfo object_info, 
+				  const MeshInfo mesh_info, const float3 orig, const float3 dir, const float maxDist)
+{
+	__global TRI_FACE* faces = MeshFaces(mesh, mesh_info);
+	
+#ifdef MESH_BVH
+	float3 objOrig = MatPoint(object_info.toObject, orig);
+	float3 objDir = MatDir(object_info.toObject, dir);
+	float3 invDir = 1.0f / objDir;
+	unsigned int stack[BVH_STACK_SIZE];
+	unsigned int sp = 0;
+	unsigned int ni = 0;
+	
+	while (true) {
+	
+		BVHNode node = bvh[ni];
+		
+		if (node.tCount > 0) {
+		
+			for (unsigned int li=0; li<node.tCount; li++) {
+				Polygon poly = FaceRelMesh(verts, faces[bvh_index[node.leftFirst+li]], mesh_info);
+				RTResult rtr = secondRayTriIntersect(objOrig, objDir, poly);
+				if (rtr.hit && rtr.dist > 0.0f && rtr.dist < maxDist) { return true; }
+			}
+			
+			if (sp == 0) { break; }
+			ni = stack[--sp];
+			continue;
+		}
+		
+		// child order doesn't matter when any hit will do
+		unsigned int c1 = node.leftFirst;
+		bool h1 = rayNodeIntersect(objOrig, invDir, bvh[c1], maxDist) != FLT_MAX;
+		bool h2 = rayNodeIntersect(objOrig, invDir, bvh[c1+1], maxDist) != FLT_MAX;
+		
+		if (h1) {
+			ni = c1;
+			if (h2) { stack[sp++] = c1+1; }
+		} else if (h2) {
+			ni = c1+1;
+		} else {
+			if (sp == 0) { break; }
+			ni = stack[--sp];
+		}
+	}
+#else
+	for (unsigned int ti=0; ti<mesh_info.tCount; ti++) {
+		Polygon poly = FaceRelObject(world_verts, faces[ti]);
+		RTResult rtr = secondRayTriIntersect(orig, dir, poly);
+		if (rtr.hit && rtr.dist > 0.0f && rtr.dist < maxDist) { return true; }
+	}
+#endif
+
+	return false;
+}
+
+// the hierarchy given here also holds objects off screen so they still cast shadows
+bool OccludedScene(VERT_POOL vert_pool, __global float3* wvert_pool, TRI_POOL tri_pool, 
+				   __global BVHNode* bvh_pool, __global unsigned int* index_pool, __global Instance* instances, 
+				   __global BVHNode* tlas, __global unsigned int* tlas_index, const float3 orig, 
+				   const float3 dir, const float maxDist)
+{
+	float3 invDir = 1.0f / dir;
+	unsigned int stack[BVH_STACK_SIZE];
+	unsigned int sp = 0;
+	unsigned int ni = 0;
+	
+	while (true) {
+	
+		BVHNode node = tlas[ni];
+		
+		if (node.tCount > 0) {
+		
+			for (unsigned int li=0; li<node.tCount; li++) {
+			
+				__global Instance* inst = &instances[tlas_index[node.leftFirst+li]];
+				
+				// objects such as light bulbs don't cast shadows
+				if (inst->occluder == 0) { continue; }
+				
+				if (inst->object.type == -1) {
+					float sDist = raySphereIntersect(orig, dir, inst->object.position, inst->object.radius2);
+					if (sDist > 0.0f && sDist < maxDist) { return true; }
+				} else if (OccludedMesh(vert_pool + inst->mesh.vOffset, wvert_pool + inst->wvOffset, 
+						   tri_pool + inst->mesh.tOffset, bvh_pool + inst->mesh.bOffset, index_pool + inst->mesh.iOffset, 
+						   inst->object, inst->mesh, orig, dir, maxDist)) {
+					return true;
+				}
+			}
+			
+			if (sp == 0) { break; }
+			ni = stack[--sp];
+			continue;
+		}
+		
+		unsigned int c1 = node.leftFirst;
+		bool h1 = rayNodeIntersect(orig, invDir, tlas[c1], maxDist) != FLT_MAX;
+		bool h2 = rayNodeIntersect(orig, invDir, tlas[c1+1], maxDist) != FLT_MAX;
+		
+		if (h1) {
+			ni = c1;
+			if (h2) { stack[sp++] = c1+1; }
+		} else if (h2) {
+			ni = c1+1;
+		} else {
+			if (sp == 0) { break; }
+			ni = stack[--sp];
+		}
+	}
+	
+	return false;
+}
+
+float3 LightContrib(VERT_POOL vert_pool, __global float3* wvert_pool, TRI_POOL tri_pool, 
+					__global BVHNode* bvh_pool, __global unsigned int* index_pool, __global Instance* instances, 
+					__global BVHNode* tlas, __global unsigned int* tlas_index, const Light lt, const float shadow_dist,
+					const float3 point, const float3 nrm, const float3 orig)
+{
+	float3 toLight;
+	float dist, atten;
+	
+	if (lt.type == 0) {
+		// endless lights only have a direction
+		toLight = VectNorm(VectNeg(lt.direction));
+		dist = shadow_dist;
+		atten = 1.0f;
+	} else {
+		toLight = lt.position - point;
+		dist = VectMag(toLight);
+		if (dist >= lt.range) { return (float3)(0.0f,0.0f,0.0f); }
+		toLight = toLight / dist;
+		atten = 1.0f - (dist / lt.range);
+	}
+	
+	float nDotL = VectDot(nrm, toLight);
+	
+	if (nDotL <= 0.0f) { return (float3)(0.0f,0.0f,0.0f); }
+	
+	if (OccludedScene(vert_pool, wvert_pool, tri_pool, bvh_pool, index_pool, 
+		instances, tlas, tlas_index, orig, toLight, dist)) { return (float3)(0.0f,0.0f,0.0f); }
+	
+	return lt.color * (lt.power * atten * nDotL);
+}
+
+// finds the screen tile and depth slice holding a hit, the hit is projected back onto
+// the screen so the tile does not depend on where its ray is stored
+unsigned int HitCluster(const ClusterInfo cluster_info, const RenderInfo render_info, const float3 point)
+{
+	float3 view = MatPoint(render_info.cam_mat, point);
+	float z = view.z;
+	float scale = render_info.cam_foc / max(z, cluster_info.near_z);
+	float pix_X = view.x * scale - dot(render_info.bl_ray, render_info.cam_rgt);
+	float pix_Y = view.y * scale - dot(render_info.bl_ray, render_info.cam_up);
+	int tile_X = clamp((int)(pix_X / cluster_info.tile_size), 0, (int)cluster_info.tiles_X-1);
+	int tile_Y = clamp((int)(pix_Y / cluster_info.tile_size), 0, (int)cluster_info.tiles_Y-1);
+	int slice = (z > cluster_info.near_z) ? (int)(log(z / cluster_info.near_z) * cluster_info.log_scale) : 0;
+	slice = clamp(slice, 0, (int)cluster_info.slices-1);
+	return (((slice * cluster_info.tiles_Y) + tile_Y) * cluster_info.tiles_X) + tile_X;
+}
+
+// sums the ambient light and every unblocked light reaching the point
+float3 ShadeSurface(VERT_POOL vert_pool, __global float3* wvert_pool, TRI_POOL tri_pool, 
+					__global BVHNode* bvh_pool, __global unsigned int* index_pool, __global Instance* instances, 
+					__global BVHNode* tlas, __global unsigned int* tlas_index, __global Light* lights, 
+					__global unsigned int* cluster_lights, __global unsigned int* cluster_counts, 
+					const ClusterInfo cluster_info, const float3 amb_light, const float shadow_dist, 
+					const float3 point, const float3 normal, const float3 ray, const unsigned int cluster)
+{
+	float3 light = amb_light;
+	
+	// light the side facing the camera
+	float3 nrm = (VectDot(normal, ray) > 0.0f) ? VectNeg(normal) : normal;
+	float3 orig = point + (nrm * SHADOW_BIAS);
+	
+	// endless lights come first and reach every cluster
+	for (unsigned int l=0; l<cluster_info.light_first; l++) {
+		light += LightContrib(vert_pool, wvert_pool, tri_pool, bvh_pool, index_pool, instances, 
+				 tlas, tlas_index, lights[l], shadow_dist, point, nrm, orig);
+	}
+	
+	// falloff lights only where their range overlaps the cluster
+	unsigned int first = cluster * CLUSTER_LIGHTS;
+	unsigned int count = cluster_counts[cluster];
+	
+	for (unsigned int ci=0; ci<count; ci++) {
+		light += LightContrib(vert_pool, wvert_pool, tri_pool, bvh_pool, index_pool, instances, 
+				 tlas, tlas_index, lights[cluster_lights[first+ci]], shadow_dist, point, nrm, orig);
+	}
+	
+	return VectMin(light, 1.0f);
+}
+
+RGB32 LightColor(const RGB32 color, const float3 light)
+{
+	RGB32 result;
+	result.red = color.red * light.x;
+	result.green = color.green * light.y;
+	result.blue = color.blue * light.z;
+	result.alpha = color.alpha;
+	return result;
+}
+
+// ------------------------------ //
+// ------ REFLECT FUNCTIONS ----- //
+// ------------------------------ //
+
+// reflection rays keep the closest hit and treat every surface as opaque
+float NearestMesh(VERT_POOL verts, __global float3* world_verts, TRI_POOL mesh, 
+				  __global BVHNode* bvh, __global unsigned int* bvh_index, const ObjectInfo object_info, 
+				  const MeshInfo mesh_info, const float3 orig, const float3 dir, float maxDist, 
+				  unsigned int* tri_id, float2* uv)
+{
+	__global TRI_FACE* faces = MeshFaces(mesh, mesh_info);
+	
+#ifdef MESH_BVH
+	float3 objOrig = MatPoint(object_info.toObject, orig);
+	float3 objDir = MatDir(object_info.toObject, dir);
+	float3 invDir = 1.0f / objDir;
+	unsigned int stack[BVH_STACK_SIZE];
+	unsigned int sp = 0;
+	unsigned int ni = 0;
+	
+	while (true) {
+	
+		BVHNode node = bvh[ni];
+		
+		if (node.tCount > 0) {
+		
+			for (unsigned int li=0; li<node.tCount; li++) {
+				unsigned int ti = bvh_index[node.leftFirst+li];
+				Polygon poly = FaceRelMesh(verts, faces[ti], mesh_info);
+				RTResult rtr = secondRayTriIntersect(objOrig, objDir, poly);
+				if (rtr.hit && rtr.dist > 0.0f && rtr.dist < maxDist) {
+					maxDist = rtr.dist;
+					*tri_id = ti;
+					*uv = rtr.uv;
+				}
+			}
+			
+			if (sp == 0) { break; }
+			ni = stack[--sp];
+			continue;
+		}
+		
+		unsigned int c1 = node.leftFirst;
+		unsigned int c2 = node.leftFirst + 1;
+		float d1 = rayNodeIntersect(objOrig, invDir, bvh[c1], maxDist);
+		float d2 = rayNodeIntersect(objOrig, invDir, bvh[c2], maxDist);
+		
+		if (d1 > d2) {
+			float td = d1; d1 = d2; d2 = td;
+			unsigned int tc = c1; c1 = c2; c2 = tc;
+		}
+		
+		if (d1 == FLT_MAX) {
+			if (sp == 0) { break; }
+			ni = stack[--sp];
+		} else {
+			ni = c1;
+			if (d2 != FLT_MAX) { stack[sp++] = c2; }
+		}
+	}
+#else
+	for (unsigned int ti=0; ti<mesh_info.tCount; ti++) {
+		Polygon poly = FaceRelObject(world_verts, faces[ti]);
+		RTResult rtr = secondRayTriIntersect(orig, dir, poly);
+		if (rtr.hit && rtr.dist > 0.0f && rtr.dist < maxDist) {
+			maxDist = rtr.dist;
+			*tri_id = ti;
+			*uv = rtr.uv;
+		}
+	}
+#endif
+
+	return maxDist;
+}
+
+// reflections can show anything in range, so the hierarchy given here includes objects off screen
+float NearestScene(VERT_POOL vert_pool, __global float3* wvert_pool, TRI_POOL tri_pool, 
+				   __global BVHNode* bvh_pool, __global unsigned int* index_pool, __global Instance* instances, 
+				   __global BVHNode* tlas, __global unsigned int* tlas_index, const float3 orig, const float3 dir, 
+				   float maxDist, unsigned int* inst_id, unsigned int* tri_id, float2* uv)
+{
+	float3 invDir = 1.0f / dir;
+	unsigned int stack[BVH_STACK_SIZE];
+	unsigned int sp = 0;
+	unsigned int ni = 0;
+	
+	while (true) {
+	
+		BVHNode node = tlas[ni];
+		
+		if (node.tCount > 0) {
+		
+			for (unsigned int li=0; li<node.tCount; li++) {
+			
+				unsigned int ii = tlas_index[node.leftFirst+li];
+				__global Instance* inst = &instances[ii];
+				
+				if (inst->object.type == -1) {
+					float sDist = raySphereIntersect(orig, dir, inst->object.position, inst->object.radius2);
+					if (sDist > 0.0f && sDist < maxDist) {
+						maxDist = sDist;
+						*inst_id = ii;
+						*tri_id = 0;
+					}
+				} else {
+					float mDist = NearestMesh(vert_pool + inst->mesh.vOffset, wvert_pool + inst->wvOffset, 
+								  tri_pool + inst->mesh.tOffset, bvh_pool + inst->mesh.bOffset, index_pool + inst->mesh.iOffset, 
+								  inst->object, inst->mesh, orig, dir, maxDist, tri_id, uv);
+					if (mDist < maxDist) {
+						maxDist = mDist;
+						*inst_id = ii;
+					}
+				}
+			}
+			
+			if (sp == 0) { break; }
+			ni = stack[--sp];
+			continue;
+		}
+		
+		unsigned int c1 = node.leftFirst;
+		unsigned int c2 = node.leftFirst + 1;
+		float d1 = rayNodeIntersect(orig, invDir, tlas[c1], maxDist);
+		float d2 = rayNodeIntersect(orig, invDir, tlas[c2], maxDist);
+		
+		if (d1 > d2) {
+			float td = d1; d1 = d2; d2 = td;
+			unsigned int tc = c1; c1 = c2; c2 = tc;
+		}
+		
+		if (d1 == FLT_MAX) {
+			if (sp == 0) { break; }
+			ni = stack[--sp];
+		} else {
+			ni = c1;
+			if (d2 != FLT_MAX) { stack[sp++] = c2; }
+		}
+	}
+	
+	return maxDist;
+}
+
+// starts a reflection ray off the side of the surface facing the incoming ray
+SecRay ReflectRay(SecRay sec, const float3 point, const float3 normal, const float3 ray)
+{
+	float3 nrm = (VectDot(normal, ray) > 0.0f) ? VectNeg(normal) : normal;
+	sec.origin = point + (nrm * REFL_BIAS);
+	sec.dir = VectNorm(VectRefl(ray, nrm));
+	return sec;
+}
+
+float3 ColorVect(const RGB32 color)
+{
+	return (float3)(color.red, color.green, color.blue);
+}
+
+// ------------------------------ //
+// ------ KERNEL FUNCTIONS ------ //
+// ------------------------------ //
+
+__kernel void ComputeStage0x1(__global PRay* ray_buffer, const RenderInfo render_info)
+{
+    unsigned int pix_X = get_global_id(0);
+	unsigned int pix_Y = get_global_id(1);
+	unsigned int pix_index = (pix_Y * render_info.pixels_X) + pix_X;
+	PRay primaryRay;
+	
+	// through the pixel center so refined pixels line up with the rest
+	primaryRay.ray = render_info.bl_ray + (render_info.cam_rgt * (pix_X + 0.5f + render_info.jitter_X));
+	primaryRay.ray = VectNorm(primaryRay.ray + (render_info.cam_up * (pix_Y + 0.5f + render_info.jitter_Y)));
+	primaryRay.intersects = 0;
+	ray_buffer[pix_index] = primaryRay;
+}
+
+__kernel void ComputeStage0xN(__global PRay* ray_buffer, const RenderInfo render_info)
+{
+    unsigned int pix_X = get_global_id(0);
+	unsigned int pix_Y = get_global_id(1);
+	unsigned int pix_index = (pix_Y * render_info.pixels_X) + pix_X;
+	unsigned int ray_index = pix_index * AA_LVL;
+	PRay primaryRay;
+	
+	// sub-rays go through the centers of an AA_DIM x AA_DIM grid inside the pixel
+	for (unsigned int sy=0; sy < AA_DIM; sy++) {
+		for (unsigned int sx=0; sx < AA_DIM; sx++) {
+		
+			float xr = pix_X + (sx + 0.5f) / AA_DIM + render_info.jitter_X;
+			float yr = pix_Y + (sy + 0.5f) / AA_DIM + render_info.jitter_Y;
+			primaryRay.ray = render_info.bl_ray + (render_info.cam_rgt * xr);
+			primaryRay.ray = VectNorm(primaryRay.ray + (render_info.cam_up * yr));
+			primaryRay.intersects = 0;
+			ray_buffer[ray_index] = primaryRay;
+			ray_index++;
+		}
+	}
+}
+
+// sub-rays for the pixels in the refine list, AA_LVL consecutive rays per pixel,
+// launched for every slot so the list length never has to be read by the host
+__kernel void ComputeStage0A(__global PRay* ray_buffer, __global unsigned int* refine_list, 
+__global unsigned int* refine_count, __global unsigned int* queue_count, const unsigned int refine_cap, 
+const RenderInfo render_info)
+{
+	unsigned int ray_index = get_global_id(0);
+	unsigned int ray_total = min(*refine_count, refine_cap) * AA_LVL;
+	
+	if (ray_index >= refine_cap * AA_LVL) { return; }
+	if (ray_index == 0) { *queue_count = ray_total; }
+	
+	// unused slots are shaded as misses
+	if (ray_index >= ray_total) { ray_buffer[ray_index].intersects = 0; return; }
+	
+	unsigned int pix_index = refine_list[ray_index / AA_LVL];
+	unsigned int sub_index = ray_index % AA_LVL;
+	float xr = (pix_index % render_info.pixels_X) + ((sub_index % AA_DIM) + 0.5f) / AA_DIM;
+	float yr = (pix_index / render_info.pixels_X) + ((sub_index / AA_DIM) + 0.5f) / AA_DIM;
+	PRay primaryRay;
+	
+	primaryRay.ray = render_info.bl_ray + (render_info.cam_rgt * xr);
+	primaryRay.ray = VectNorm(primaryRay.ray + (render_info.cam_up * yr));
+	primaryRay.intersects = 0;
+	ray_buffer[ray_index] = primaryRay;
+}
+
+__kernel void ComputeStage1V(VERT_POOL verts, __global float3* world_verts, const ObjectInfo object_info, 
+const unsigned int vert_offset, const unsigned int wvert_offset, const unsigned int vert_count, const MeshInfo mesh_info)
+{
+	unsigned int vi = get_global_id(0);
+	
+	if (vi >= vert_count) { return; }
+	
+	world_verts[wvert_offset+vi] = VertRelWorld(MeshVert(verts, vert_offset+vi, mesh_info), object_info);
+}
+
+__kernel void ComputeStage1S(__global PRay* ray_buffer, __global float* hit_buffer,
+__global RGB32* cid_buffer, __global ObjectInfo* spheres, __global BVHNode* sph_bvh, 
+__global unsigned int* sph_index, const RenderInfo render_info)
+{
+	LayerSet layers = HitLayers(hit_buffer, cid_buffer, render_info);
+    unsigned int pix_X = get_global_id(0);
+	unsigned int pix_Y = get_global_id(1);
+	unsigned int pix_index = (pix_Y * render_info.pixels_X) + pix_X;
+	unsigned int ray_index = pix_index * AA_LVL;
+	
+	// every visible sphere is traced in this one launch
+	for (unsigned int r=AA_LVL; r-- > 0; ray_index++) {
+	
+		PRay primRay = ray_buffer[ray_index];
+		
+		unsigned char ric = TraceSpheres(layers, spheres, sph_bvh, sph_index, render_info, 
+							primRay.ray, ray_index, primRay.intersects);
+		
+		if (primRay.intersects != ric) {
+			ray_buffer[ray_index].intersects = ric;
+		}
+	}
+}
+
+__kernel void ComputeStage1T(__global PRay* ray_buffer, __global float* hit_buffer,
+__global RGB32* cid_buffer, __global Material* mat_set, VERT_POOL verts, __global float3* world_verts,
+TRI_POOL mesh, __global BVHNode* bvh, __global unsigned int* bvh_index, TEX_POOL texture, 
+__global ushort2* norm_map, const ObjectInfo object_info, const MeshInfo mesh_info, const TexInfo tex_info, 
+const RenderInfo render_info, const unsigned int wvert_offset)
+{
+	LayerSet layers = HitLayers(hit_buffer, cid_buffer, render_info);
+    unsigned int pix_X = get_global_id(0);
+	unsigned int pix_Y = get_global_id(1);
+	unsigned int pix_index = (pix_Y * render_info.pixels_X) + pix_X;
+	
+#if defined(TRI_TILING) && !defined(MESH_BVH)
+	__local Polygon tile_polys[TRI_TILE_SIZE];
+	
+	TracePixelTiled(ray_buffer, layers, mat_set, verts, world_verts + wvert_offset, mesh, 
+					texture, object_info, mesh_info, tex_info, render_info, tile_polys, pix_index);
+#else
+	TracePixelMesh(ray_buffer, layers, mat_set, verts, world_verts + wvert_offset, mesh, bvh, 
+				   bvh_index, texture, object_info, mesh_info, tex_info, render_info, pix_index);
+#endif
+}
+
+__kernel void ComputeStage1TP(__global PRay* ray_buffer, __global float* hit_buffer,
+__global RGB32* cid_buffer, __global Material* mat_set, VERT_POOL verts, __global float3* world_verts,
+TRI_POOL mesh, __global BVHNode* bvh, __global unsigned int* bvh_index, TEX_POOL texture, 
+__global ushort2* norm_map, const ObjectInfo object_info, const MeshInfo mesh_info, const TexInfo tex_info, 
+const RenderInfo render_info, const unsigned int wvert_offset, volatile __global unsigned int* work_counter, 
+const uint4 pix_box)
+{
+	LayerSet layers = HitLayers(hit_buffer, cid_buffer, render_info);
+	__local unsigned int batch;
+	unsigned int pix_count = pix_box.z * pix_box.w;
+	
+	// keep pulling pixels from the 2D bounding box until none are left
+	for (unsigned int first = NextPixelBatch(work_counter, &batch); first < pix_count; 
+		 first = NextPixelBatch(work_counter, &batch)) {
+		 
+		unsigned int bi = first + get_local_id(0);
+		
+		if (bi >= pix_count) { continue; }
+		
+		unsigned int pix_X = pix_box.x + (bi % pix_box.z);
+		unsigned int pix_Y = pix_box.y + (bi / pix_box.z);
+		
+		TracePixelMesh(ray_buffer, layers, mat_set, verts, world_verts + wvert_offset, mesh, bvh, 
+					   bvh_index, texture, object_info, mesh_info, tex_info, render_info, 
+					   (pix_Y * render_info.pixels_X) + pix_X);
+	}
+}
+
+__kernel void ComputeStage1W(__global PRay* ray_buffer, __global float* hit_buffer,
+__global RGB32* cid_buffer, __global Material* mat_set, VERT_POOL vert_pool, __global float3* wvert_pool, 
+TRI_POOL tri_pool, __global BVHNode* bvh_pool, __global unsigned int* index_pool, TEX_POOL tex_pool, 
+__global Instance* instances, __global BVHNode* tlas, __global unsigned int* tlas_index, const RenderInfo render_info)
+{
+	LayerSet layers = HitLayers(hit_buffer, cid_buffer, render_info);
+    unsigned int pix_X = get_global_id(0);
+	unsigned int pix_Y = get_global_id(1);
+	unsigned int pix_index = (pix_Y * render_info.pixels_X) + pix_X;
+	
+	TracePixelScene(ray_buffer, layers, mat_set, vert_pool, wvert_pool, tri_pool, bvh_pool, 
+					index_pool, tex_pool, instances, tlas, tlas_index, render_info, pix_index);
+}
+
+__kernel void ComputeStage1WP(__global PRay* ray_buffer, __global float* hit_buffer,
+__global RGB32* cid_buffer, __global Material* mat_set, VERT_POOL vert_pool, __global float3* wvert_pool, 
+TRI_POOL tri_pool, __global BVHNode* bvh_pool, __global unsigned int* index_pool, TEX_POOL tex_pool, 
+__global Instance* instances, __global BVHNode* tlas, __global unsigned int* tlas_index, const RenderInfo render_info,
+volatile __global unsigned int* work_counter, const unsigned int pix_count)
+{
+	LayerSet layers = HitLayers(hit_buffer, cid_buffer, render_info);
+	__local unsigned int batch;
+	
+	// keep pulling pixels from the whole screen until none are left
+	for (unsigned int first = NextPixelBatch(work_counter, &batch); first < pix_count; 
+		 first = NextPixelBatch(work_counter, &batch)) {
+		 
+		unsigned int pix_index = first + get_local_id(0);
+		
+		if (pix_index >= pix_count) { continue; }
+		
+		TracePixelScene(ray_buffer, layers, mat_set, vert_pool, wvert_pool, tri_pool, bvh_pool, 
+						index_pool, tex_pool, instances, tlas, tlas_index, render_info, pix_index);
+	}
+}
+
+__kernel void ComputeStage1B(__global PRay* ray_buffer, __global float* hit_buffer,
+__global RGB32* cid_buffer, __global Material* mat_set, VERT_POOL vert_pool, __global float3* wvert_pool, 
+TRI_POOL tri_pool, __global BVHNode* bvh_pool, __global unsigned int* index_pool, TEX_POOL tex_pool, 
+__global Instance* instances, __global unsigned int* tile_counts, __global unsigned int* tile_offsets, 
+__global unsigned int* tile_refs, const unsigned int tile_size, const unsigned int tiles_X, const RenderInfo render_info)
+{
+	LayerSet layers = HitLayers(hit_buffer, cid_buffer, render_info);
+    unsigned int pix_X = get_global_id(0);
+	unsigned int pix_Y = get_global_id(1);
+	unsigned int pix_index = (pix_Y * render_info.pixels_X) + pix_X;
+	unsigned int ray_index = pix_index * AA_LVL;
+	unsigned int tile = ((pix_Y / tile_size) * tiles_X) + (pix_X / tile_size);
+	unsigned int ref_first = tile_offsets[tile];
+	unsigned int ref_count = tile_counts[tile];
+	
+	for (unsigned int r=AA_LVL; r-- > 0; ray_index++) {
+
+		PRay primRay = ray_buffer[ray_index];
+		unsigned char ric = primRay.intersects;
+		
+		// only objects whose 2D bounding box overlaps this tile
+		for (unsigned int ri=0; ri<ref_count; ri++) {
+			ric = TraceInstance(layers, mat_set, vert_pool, wvert_pool, tri_pool, bvh_pool, index_pool, 
+				  tex_pool, instances, tile_refs[ref_first+ri], render_info, primRay.ray, 0.0f, ray_index, ric);
+		}
+
+		if (primRay.intersects != ric) {
+			ray_buffer[ray_index].intersects = ric;
+		}
+	}
+}
+
+__kernel void ComputeBufferClear(__global unsigned int* data, const unsigned int count)
+{
+	unsigned int gi = get_global_id(0);
+	
+	if (gi < count) { data[gi] = 0; }
+}
+
+__kernel void ComputeTileCount(__global uint4* inst_boxes, volatile __global unsigned int* tile_counts,
+const unsigned int inst_count, const unsigned int tile_size, const unsigned int tiles_X)
+{
+	unsigned int ii = get_global_id(0);
+	
+	if (ii >= inst_count) { return; }
+	
+	uint4 box = inst_boxes[ii] / tile_size;
+	
+	for (unsigned int ty=box.y; ty<=box.w; ty++) {
+		for (unsigned int tx=box.x; tx<=box.z; tx++) {
+			atomic_inc(&tile_counts[(ty * tiles_X) + tx]);
+		}
+	}
+}
+
+__kernel void ComputeTileFill(__global uint4* inst_boxes, __global unsigned int* tile_offsets, 
+volatile __global unsigned int* tile_fill, __global unsigned int* tile_refs, const unsigned int inst_count, 
+const unsigned int tile_size, const unsigned int tiles_X)
+{
+	unsigned int ii = get_global_id(0);
+	
+	if (ii >= inst_count) { return; }
+	
+	uint4 box = inst_boxes[ii] / tile_size;
+	
+	for (unsigned int ty=box.y; ty<=box.w; ty++) {
+		for (unsigned int tx=box.x; tx<=box.z; tx++) {
+			unsigned int tile = (ty * tiles_X) + tx;
+			tile_refs[tile_offsets[tile] + atomic_inc(&tile_fill[tile])] = ii;
+		}
+	}
+}
+
+__kernel void ComputeQueueInit(__global unsigned int* ray_queue, const unsigned int ray_count)
+{
+	unsigned int qi = get_global_id(0);
+	
+	if (qi < ray_count) { ray_queue[qi] = qi; }
+}
+
+__kernel void ComputeStage1Q(__global PRay* ray_buffer, __global float* hit_buffer,
+__global RGB32* cid_buffer, __global Material* mat_set, VERT_POOL vert_pool, __global float3* wvert_pool, 
+TRI_POOL tri_pool, __global BVHNode* bvh_pool, __global unsigned int* index_pool, TEX_POOL tex_pool, 
+__global Instance* instances, __global BVHNode* tlas, __global unsigned int* tlas_index, __global unsigned int* ray_queue, 
+__global unsigned int* ray_alive, __global unsigned int* queue_count, const unsigned int queue_cap, 
+const unsigned int layer, const RenderInfo render_info)
+{
+	unsigned int qi = get_global_id(0);
+	
+	if (qi >= queue_cap) { return; }
+	
+	// the queue is launched at capacity, entries past its length are cleared for the next compaction
+	if (qi >= *queue_count) { ray_alive[qi] = 0; return; }
+	
+	LayerSet layers = HitLayers(hit_buffer, cid_buffer, render_info);
+	unsigned int ray_index = ray_queue[qi];
+	unsigned int layer_index = ray_index + (layer * layers.stride);
+	float minDist = (layer > 0) ? layers.depth[layer_index-layers.stride] : 0.0f;
+	
+	// each pass only keeps the nearest hit behind the previous layer
+	RenderInfo layer_info = render_info;
+	layer_info.t_depth = 1;
+	
+	unsigned char ric = TraceScene(layers, mat_set, vert_pool, wvert_pool, tri_pool, bvh_pool, 
+						index_pool, tex_pool, instances, tlas, tlas_index, layer_info, ray_buffer[ray_index].ray, 
+						minDist, layer_index, 0);
+	
+	if (ric > 0) { ray_buffer[ray_index].intersects = layer + 1; }
+	
+	// rays stay in the queue until they hit something opaque or run out of layers
+	ray_alive[qi] = (ric > 0 && layers.color[layer_index].alpha != 255 && layer+1 < T_DEPTH) ? 1 : 0;
+}
+
+__kernel void ComputeScanLocal(__global unsigned int* data_in, __global unsigned int* data_out,
+__global unsigned int* group_sums, const unsigned int count)
+{
+	__local unsigned int scan[SCAN_SIZE];
+	unsigned int gi = get_global_id(0);
+	unsigned int li = get_local_id(0);
+	unsigned int value = (gi < count) ? data_in[gi] : 0;
+	
+	scan[li] = value;
+	barrier(CLK_LOCAL_MEM_FENCE);
+	
+	for (unsigned int offset = 1; offset < SCAN_SIZE; offset <<= 1) {
+		unsigned int add = (li >= offset) ? scan[li-offset] : 0;
+		barrier(CLK_LOCAL_MEM_FENCE);
+		scan[li] += add;
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+	
+	// store as an exclusive scan, last item holds the group total
+	if (gi < count) { data_out[gi] = scan[li] - value; }
+	if (li == SCAN_SIZE-1) { group_sums[get_group_id(0)] = scan[li]; }
+}
+
+__kernel void ComputeScanAdd(__global unsigned int* data, __global unsigned int* group_sums, const unsigned int count)
+{
+	unsigned int gi = get_global_id(0);
+	
+	if (gi < count) { data[gi] += group_sums[get_group_id(0)]; }
+}
+
+__kernel void ComputeQueueCompact(__global unsigned int* ray_queue, __global unsigned int* ray_alive,
+__global unsigned int* ray_scan, __global unsigned int* next_queue, __global unsigned int* next_count,
+const unsigned int queue_cap)
+{
+	unsigned int qi = get_global_id(0);
+	
+	if (qi >= queue_cap) { return; }
+	
+	// the new length stays on the device for the kernels which read the next queue
+	if (ray_alive[qi] != 0) { next_queue[ray_scan[qi]] = ray_queue[qi]; }
+	if (qi == queue_cap-1) { *next_count = ray_scan[qi] + ray_alive[qi]; }
+}
+
+__kernel void ComputeLightClusters(__global Light* lights, __global unsigned int* cluster_lights, 
+__global unsigned int* cluster_counts, volatile __global unsigned int* cluster_overflow, 
+const ClusterInfo cluster_info, const RenderInfo render_info)
+{
+	unsigned int cluster = get_global_id(0);
+	unsigned int tiles = cluster_info.tiles_X * cluster_info.tiles_Y;
+	
+	if (cluster >= tiles * cluster_info.slices) { return; }
+	
+	unsigned int slice = cluster / tiles;
+	unsigned int tile = cluster % tiles;
+	float x0 = (tile % cluster_info.tiles_X) * cluster_info.tile_size;
+	float y0 = (tile / cluster_info.tiles_X) * cluster_info.tile_size;
+	float x1 = x0 + cluster_info.tile_size;
+	float y1 = y0 + cluster_info.tile_size;
+	
+	// slices grow exponentially with depth, the first one reaches the camera
+	float z0 = (slice == 0) ? 0.0f : cluster_info.near_z * exp(slice / cluster_info.log_scale);
+	float z1 = cluster_info.near_z * exp((slice+1) / cluster_info.log_scale);
+	
+	// rays through the tile corners in view space, each with z at the focal length
+	float3 bl = MatDir(render_info.cam_mat, render_info.bl_ray);
+	float3 rgt = MatDir(render_info.cam_mat, render_info.cam_rgt);
+	float3 up = MatDir(render_info.cam_mat, render_info.cam_up);
+	float3 corners[4];
+	corners[0] = bl + (rgt * x0) + (up * y0);
+	corners[1] = bl + (rgt * x1) + (up * y0);
+	corners[2] = bl + (rgt * x0) + (up * y1);
+	corners[3] = bl + (rgt * x1) + (up * y1);
+	
+	float3 bMin = (float3)(FLT_MAX, FLT_MAX, FLT_MAX);
+	float3 bMax = (float3)(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	
+	for (unsigned int c=0; c<4; c++) {
+		float3 p0 = corners[c] * (z0 / corners[c].z);
+		float3 p1 = corners[c] * (z1 / corners[c].z);
+		bMin = fmin(bMin, fmin(p0, p1));
+		bMax = fmax(bMax, fmax(p0, p1));
+	}
+	
+	unsigned int first = cluster * CLUSTER_LIGHTS;
+	unsigned int count = 0;
+	unsigned int dropped = 0;
+	
+	// keep falloff lights whose sphere of influence touches the cluster box
+	for (unsigned int l=cluster_info.light_first; l<cluster_info.light_count; l++) {
+		Light lt = lights[l];
+		float3 pos = MatPoint(render_info.cam_mat, lt.position);
+		float3 gap = pos - clamp(pos, bMin, bMax);
+		if (VectDot(gap, gap) < lt.range * lt.range) {
+			if (count < CLUSTER_LIGHTS) { cluster_lights[first + count++] = l; } else { dropped++; }
+		}
+	}
+	
+	cluster_counts[cluster] = count;
+	
+	// full clusters and the lights they lost are reported by the host
+	if (dropped > 0) {
+		atomic_inc(&cluster_overflow[0]);
+		atomic_add(&cluster_overflow[1], dropped);
+	}
+}
+
+__kernel void ComputeStage1L(__global PRay* ray_buffer, __global float* hit_buffer, __global RGB32* cid_buffer, 
+VERT_POOL vert_pool, __global float3* wvert_pool, TRI_POOL tri_pool, __global BVHNode* bvh_pool, 
+__global unsigned int* index_pool, __global Instance* instances, __global BVHNode* world_tlas, __global unsigned int* world_index, 
+__global Light* lights, __global unsigned int* cluster_lights, __global unsigned int* cluster_counts, 
+const ClusterInfo cluster_info, const float3 amb_light, const float shadow_dist, const RenderInfo render_info)
+{
+#if defined(LIGHTING) && !defined(VIS_BUFFER)
+	unsigned int ray_index = get_global_id(0);
+	
+	if (ray_index >= render_info.ray_count) { return; }
+	
+	LayerSet layers = HitLayers(hit_buffer, cid_buffer, render_info);
+	PRay primRay = ray_buffer[ray_index];
+	unsigned char ric = primRay.intersects;
+	
+	// every visible layer gets its own shadow rays
+	for (unsigned char d=0; d<ric; d++) {
+	
+		unsigned int li = ray_index + d * layers.stride;
+		
+		if (layers.matIndex[li] == LIGHT_MAT) { continue; }
+		
+		float3 pntVect = layers.point[li];
+		float3 light = ShadeSurface(vert_pool, wvert_pool, tri_pool, bvh_pool, index_pool, instances, world_tlas, world_index, 
+					   lights, cluster_lights, cluster_counts, cluster_info, amb_light, shadow_dist, pntVect, 
+					   layers.normal[li], primRay.ray, HitCluster(cluster_info, render_info, pntVect));
+		layers.color[li] = LightColor(layers.color[li], light);
+	}
+#endif
+}
+
+__kernel void ComputeResolve(__global PRay* ray_buffer, __global float* hit_buffer, __global RGB32* cid_buffer, 
+__global Material* mat_set, VERT_POOL vert_pool, __global float3* wvert_pool, TRI_POOL tri_pool, 
+__global BVHNode* bvh_pool, __global unsigned int* index_pool, TEX_POOL tex_pool, __global Instance* instances, 
+__global BVHNode* world_tlas, __global unsigned int* world_index, __global Light* lights, __global unsigned int* cluster_lights, 
+__global unsigned int* cluster_counts, const ClusterInfo cluster_info, const float3 amb_light, const float shadow_dist, 
+const RenderInfo render_info)
+{
+#ifdef VIS_BUFFER
+	unsigned int ray_index = get_global_id(0);
+	
+	if (ray_index >= render_info.ray_count) { return; }
+	
+	LayerSet layers = HitLayers(hit_buffer, cid_buffer, render_info);
+	PRay primRay = ray_buffer[ray_index];
+	unsigned char ric = primRay.intersects;
+	
+	// surfaces are only evaluated for the layers which survived intersection
+	for (unsigned char d=0; d<ric; d++) {
+	
+		unsigned int li = ray_index + d * layers.stride;
+		__global Instance* inst = &instances[layers.instId[li]];
+		
+		if (inst->object.type == -1) {
+			layers.color[li] = inst->object.color;
+		} else {
+			Triangle tri = MeshTri(tri_pool, inst->mesh.tOffset + layers.triId[li]);
+			float2 uv = layers.bary[li];
+			Polygon poly = TriRelMesh(vert_pool + inst->mesh.vOffset, tri, inst->mesh);
+			TexInfo level = SurfLevel(tri, poly, MatDir(inst->object.toObject, primRay.ray), inst->object.scale * inst->object.scale, 
+							inst->tex, ConeWidth(render_info, primRay.ray, layers.depth[li]));
+			RGB32 pntColor = InterpolateSurf(tex_pool, mat_set, tri, uv, level);
+#ifdef LIGHTING
+			// normals follow the vertices of each mesh in the vertex pool
+			VERT_POOL norms = vert_pool + inst->mesh.vOffset + inst->mesh.vCount;
+			float3 nrmVect = VectNorm(MatDir(inst->object.toWorld, InterpolateNorm(norms, &(tri.normIndex[0]), uv, tri.type)));
+			float3 pntVect = render_info.cam_pos + (primRay.ray * layers.depth[li]);
+			pntColor = LightColor(pntColor, ShadeSurface(vert_pool, wvert_pool, tri_pool, bvh_pool, index_pool, 
+					   instances, world_tlas, world_index, lights, cluster_lights, cluster_counts, cluster_info, amb_light, 
+					   shadow_dist, pntVect, nrmVect, primRay.ray, HitCluster(cluster_info, render_info, pntVect)));
+#endif
+			layers.color[li] = pntColor;
+		}
+	}
+#endif
+}
+
+__kernel void ComputeReflectInit(__global PRay* ray_buffer, __global float* hit_buffer, __global RGB32* cid_buffer, 
+__global Material* mat_set, VERT_POOL vert_pool, TRI_POOL tri_pool, __global Instance* instances, 
+__global SecRay* sec_rays, __global unsigned int* ray_alive, const RenderInfo render_info)
+{
+	unsigned int ray_index = get_global_id(0);
+	
+	if (ray_index >= render_info.ray_count) { return; }
+	
+	LayerSet layers = HitLayers(hit_buffer, cid_buffer, render_info);
+	PRay primRay = ray_buffer[ray_index];
+	
+	ray_alive[ray_index] = 0;
+	
+	// only the nearest layer of each ray is reflected
+	if (primRay.intersects == 0) { return; }
+	
+#ifdef VIS_BUFFER
+	__global Instance* inst = &instances[layers.instId[ray_index]];
+	
+	if (inst->object.type == -1) { return; }
+	
+	Triangle tri = MeshTri(tri_pool, inst->mesh.tOffset + layers.triId[ray_index]);
+	float refl = mat_set[tri.matIndex].reflectivity;
+	
+	if (refl <= 0.0f) { return; }
+	
+	VERT_POOL norms = vert_pool + inst->mesh.vOffset + inst->mesh.vCount;
+	float3 nrmVect = VectNorm(MatDir(inst->object.toWorld, InterpolateNorm(norms, &(tri.normIndex[0]), layers.bary[ray_index], tri.type)));
+	float3 pntVect = render_info.cam_pos + (primRay.ray * layers.depth[ray_index]);
+#else
+	unsigned int mi = layers.matIndex[ray_index];
+	
+	if (mi == LIGHT_MAT) { return; }
+	
+	float refl = mat_set[mi].reflectivity;
+	
+	if (refl <= 0.0f) { return; }
+	
+	float3 nrmVect = layers.normal[ray_index];
+	float3 pntVect = layers.point[ray_index];
+#endif
+
+	// the surface keeps its own color in proportion to how little it reflects
+	SecRay sec;
+	sec.color = ColorVect(layers.color[ray_index]) * (1.0f - refl);
+	sec.weight = refl;
+	sec.spread = ConeWidth(render_info, primRay.ray, 1.0f);
+	sec.cone = sec.spread * layers.depth[ray_index];
+	sec_rays[ray_index] = ReflectRay(sec, pntVect, nrmVect, primRay.ray);
+	ray_alive[ray_index] = 1;
+}
+
+__kernel void ComputeStage1R(__global unsigned int* ray_queue, __global unsigned int* ray_alive, 
+__global SecRay* sec_rays, __global RGB32* cid_buffer, __global Material* mat_set, VERT_POOL vert_pool, 
+__global float3* wvert_pool, TRI_POOL tri_pool, __global BVHNode* bvh_pool, __global unsigned int* index_pool, 
+TEX_POOL tex_pool, __global Instance* instances, __global BVHNode* world_tlas, __global unsigned int* world_index, 
+__global Light* lights, const ClusterInfo cluster_info, const float3 amb_light, const float shadow_dist, 
+const float refl_dist, __global unsigned int* queue_count, const unsigned int queue_cap, const unsigned int last_bounce)
+{
+	unsigned int qi = get_global_id(0);
+	
+	if (qi >= queue_cap) { return; }
+	if (qi >= *queue_count) { ray_alive[qi] = 0; return; }
+	
+	unsigned int ray_index = ray_queue[qi];
+	SecRay sec = sec_rays[ray_index];
+	unsigned int instId = 0, triId = 0;
+	float2 uv = (float2)(0.0f, 0.0f);
+	float3 hitColor = (float3)(0.0f,0.0f,0.0f);
+	float refl = 0.0f;
+	
+	float dist = NearestScene(vert_pool, wvert_pool, tri_pool, bvh_pool, index_pool, instances, 
+				 world_tlas, world_index, sec.origin, sec.dir, refl_dist, &instId, &triId, &uv);
+	
+	// rays which escape the scene add nothing
+	if (dist < refl_dist) {
+	
+		__global Instance* inst = &instances[instId];
+		
+		if (inst->object.type == -1) {
+			hitColor = ColorVect(inst->object.color);
+		} else {
+			Triangle tri = MeshTri(tri_pool, inst->mesh.tOffset + triId);
+			VERT_POOL norms = vert_pool + inst->mesh.vOffset + inst->mesh.vCount;
+			float3 nrmVect = VectNorm(MatDir(inst->object.toWorld, InterpolateNorm(norms, &(tri.normIndex[0]), uv, tri.type)));
+			float3 pntVect = sec.origin + (sec.dir * dist);
+			
+			// the cone keeps spreading from where the reflection started
+			sec.cone += sec.spread * dist;
+			Polygon poly = TriRelMesh(vert_pool + inst->mesh.vOffset, tri, inst->mesh);
+			TexInfo level = SurfLevel(tri, poly, MatDir(inst->object.toObject, sec.dir), inst->object.scale * inst->object.scale, 
+							inst->tex, sec.cone);
+			RGB32 pntColor = InterpolateSurf(tex_pool, mat_set, tri, uv, level);
+#ifdef LIGHTING
+			// clusters belong to the screen so reflected points only see the endless lights
+			float3 nrm = (VectDot(nrmVect, sec.dir) > 0.0f) ? VectNeg(nrmVect) : nrmVect;
+			float3 orig = pntVect + (nrm * SHADOW_BIAS);
+			float3 light = amb_light;
+			for (unsigned int l=0; l<cluster_info.light_first; l++) {
+				light += LightContrib(vert_pool, wvert_pool, tri_pool, bvh_pool, index_pool, instances, 
+						 world_tlas, world_index, lights[l], shadow_dist, pntVect, nrm, orig);
+			}
+			pntColor = LightColor(pntColor, VectMin(light, 1.0f));
+#endif
+			hitColor = ColorVect(pntColor);
+			refl = mat_set[tri.matIndex].reflectivity;
+			
+			if (refl > 0.0f && last_bounce == 0) {
+				// keep bouncing, the hit only adds the part it doesn't reflect
+				sec.color += hitColor * (sec.weight * (1.0f - refl));
+				sec.weight *= refl;
+				sec_rays[ray_index] = ReflectRay(sec, pntVect, nrmVect, sec.dir);
+				ray_alive[qi] = 1;
+				return;
+			}
+		}
+	}
+	
+	// the ray is finished so its sum replaces the color of the nearest layer
+	float3 sumColor = VectMin(sec.color + (hitColor * sec.weight), 255.0f);
+	RGB32 layerColor = cid_buffer[ray_index];
+	layerColor.red = sumColor.x;
+	layerColor.green = sumColor.y;
+	layerColor.blue = sumColor.z;
+	cid_buffer[ray_index] = layerColor;
+	ray_alive[qi] = 0;
+}
+
+// blends the layers of one ray from back to front
+float3 RayColor(__global PRay* ray_buffer, __global RGB32* cid_buffer, const unsigned int ray_index, const unsigned int stride)
+{
+#if T_DEPTH > 1
+	unsigned char ric = ray_buffer[ray_index].intersects;
+	
+	if (ric == 0) { return (float3)(0.0f,0.0f,0.0f); }
+	
+	RGB32 itpColor = cid_buffer[ray_index + (ric-1)*stride];
+	
+	// fixed bound so the blend loop unrolls, color planes are layer-major so each read is coalesced
+	for (int ii=T_DEPTH-2; ii > -1; ii--) {
+		if (ii < ric-1) { itpColor = AlphaBlend(itpColor, cid_buffer[ray_index + ii*stride]); }
+	}
+#else
+	RGB32 itpColor = cid_buffer[ray_index];
+#endif
+	return (float3)(itpColor.red, itpColor.green, itpColor.blue);
+}
+
+__kernel void ComputeStage2(__global PRay* ray_buffer, __global RGB32* cid_buffer,
+write_only image2d_t pix_buffer, const RenderInfo render_info)
+{
+    unsigned int pix_X = get_global_id(0);
+	unsigned int pix_Y = get_global_id(1);
+	unsigned int pix_index = (pix_Y * render_info.pixels_X) + pix_X;
+	unsigned int ray_index = pix_index * AA_LVL;
+	float3 sumColor = (float3)(0.0f,0.0f,0.0f);
+		
+	for (unsigned int r=AA_LVL; r-- > 0; ray_index++) {
+		sumColor += RayColor(ray_buffer, cid_buffer, ray_index, render_info.ray_count);
+	}
+	
+	write_imagef(pix_buffer, (int2)(pix_X, pix_Y), VectToColor(sumColor * (1.0f / AA_LVL)));
+}
+
+// first pass of adaptive anti-aliasing, one ray per pixel
+__kernel void ComputeStage2x1(__global PRay* ray_buffer, __global RGB32* cid_buffer,
+write_only image2d_t pix_buffer, const RenderInfo render_info)
+{
+    unsigned int pix_X = get_global_id(0);
+	unsigned int pix_Y = get_global_id(1);
+	unsigned int pix_index = (pix_Y * render_info.pixels_X) + pix_X;
+	
+	write_imagef(pix_buffer, (int2)(pix_X, pix_Y), VectToColor(RayColor(ray_buffer, cid_buffer, pix_index, render_info.ray_count)));
+}
+
+bool PixelEdge(__global PRay* ray_buffer, const LayerSet layers, const unsigned int a, const unsigned int b)
+{
+	unsigned char ric = ray_buffer[a].intersects;
+	
+	if (ric != ray_buffer[b].intersects) { return true; }
+	if (ric == 0) { return false; }
+#ifdef VIS_BUFFER
+	if (layers.instId[a] != layers.instId[b]) { return true; }
+#else
+	if (layers.matIndex[a] != layers.matIndex[b]) { return true; }
+#endif
+	if (fabs(layers.depth[a] - layers.depth[b]) > EDGE_DEPTH * min(layers.depth[a], layers.depth[b])) { return true; }
+	
+	float3 diff = fabs(RayColor(ray_buffer, layers.color, a, layers.stride) - RayColor(ray_buffer, layers.color, b, layers.stride));
+	return (diff.x + diff.y + diff.z) > EDGE_COLOR;
+}
+
+// flags pixels which differ from a neighbour after the first pass
+__kernel void ComputeEdgeDetect(__global PRay* ray_buffer, __global float* hit_buffer, __global RGB32* cid_buffer, 
+__global unsigned int* edge_flags, const RenderInfo render_info)
+{
+    unsigned int pix_X = get_global_id(0);
+	unsigned int pix_Y = get_global_id(1);
+	unsigned int pix_index = (pix_Y * render_info.pixels_X) + pix_X;
+	LayerSet layers = HitLayers(hit_buffer, cid_buffer, render_info);
+	bool edge = false;
+	
+	if (pix_X > 0) { edge = edge || PixelEdge(ray_buffer, layers, pix_index, pix_index-1); }
+	if (pix_X+1 < render_info.pixels_X) { edge = edge || PixelEdge(ray_buffer, layers, pix_index, pix_index+1); }
+	if (pix_Y > 0) { edge = edge || PixelEdge(ray_buffer, layers, pix_index, pix_index-render_info.pixels_X); }
+	if (pix_Y+1 < get_global_size(1)) { edge = edge || PixelEdge(ray_buffer, layers, pix_index, pix_index+render_info.pixels_X); }
+	
+	edge_flags[pix_index] = edge ? 1 : 0;
+}
+
+// second pass of adaptive anti-aliasing, overwrites the refined pixels
+__kernel void ComputeStage2A(__global PRay* ray_buffer, __global RGB32* cid_buffer, write_only image2d_t pix_buffer, 
+__global unsigned int* refine_list, __global unsigned int* refine_count, const unsigned int refine_cap, 
+const RenderInfo render_info)
+{
+	unsigned int ri = get_global_id(0);
+	
+	if (ri >= min(*refine_count, refine_cap)) { return; }
+	
+	unsigned int pix_index = refine_list[ri];
+	unsigned int ray_index = ri * AA_LVL;
+	float3 sumColor = (float3)(0.0f,0.0f,0.0f);
+		
+	for (unsigned int r=AA_LVL; r-- > 0; ray_index++) {
+		sumColor += RayColor(ray_buffer, cid_buffer, ray_index, render_info.ray_count);
+	}
+	
+	int2 coords = (int2)(pix_index % render_info.pixels_X, pix_index / render_info.pixels_X);
+	write_imagef(pix_buffer, coords, VectToColor(sumColor * (1.0f / AA_LVL)));
+}
+
+// blends the new pixel color with the previous frame's color at the same surface point,
+// hits are moved back to where their object was and projected with the previous camera
+__kernel void ComputeStage2T(__global PRay* ray_buffer, __global float* hit_buffer, __global RGB32* cid_buffer, 
+write_only image2d_t pix_buffer, __global Instance* instances, __global float4* hist_in, __global unsigned int* hist_id_in, 
+__global float4* hist_out, __global unsigned int* hist_id_out, const RenderInfo prev_info, const RenderInfo render_info)
+{
+    unsigned int pix_X = get_global_id(0);
+	unsigned int pix_Y = get_global_id(1);
+	unsigned int pix_index = (pix_Y * render_info.pixels_X) + pix_X;
+	unsigned int ray_index = pix_index * AA_LVL;
+	LayerSet layers = HitLayers(hit_buffer, cid_buffer, render_info);
+	float3 sumColor = (float3)(0.0f,0.0f,0.0f);
+	unsigned int id = NO_HIT;
+	float depth = 0.0f;
+		
+	for (unsigned int r=AA_LVL; r-- > 0; ray_index++) {
+		sumColor += RayColor(ray_buffer, cid_buffer, ray_index, render_info.ray_count);
+	}
+	
+	sumColor *= (1.0f / AA_LVL);
+	ray_index = pix_index * AA_LVL;
+	
+#ifdef VIS_BUFFER
+	// the first sub-ray's nearest layer stands for the whole pixel
+	if (ray_buffer[ray_index].intersects > 0) {
+	
+		// instance indexes change as objects are culled so the history keeps the object's own id
+		__global Instance* inst = &instances[layers.instId[ray_index]];
+		id = inst->objectId;
+		float3 point = render_info.cam_pos + ray_buffer[ray_index].ray * layers.depth[ray_index];
+		float3 lastPoint = MatPoint(inst->lastToWorld, MatPoint(inst->object.toObject, point));
+		depth = MatPoint(render_info.cam_mat, point).z;
+		float3 view = MatPoint(prev_info.cam_mat, lastPoint);
+		
+		if (view.z > 0.0f) {
+			float scale = prev_info.cam_foc / view.z;
+			int hist_X = (int)floor(view.x * scale - dot(prev_info.bl_ray, prev_info.cam_rgt));
+			int hist_Y = (int)floor(view.y * scale - dot(prev_info.bl_ray, prev_info.cam_up));
+			
+			if (hist_X >= 0 && hist_Y >= 0 && hist_X < (int)render_info.pixels_X && hist_Y < (int)get_global_size(1)) {
+			
+				unsigned int hist_index = (hist_Y * render_info.pixels_X) + hist_X;
+				float4 hist = hist_in[hist_index];
+				
+				// a different surface or depth there means the point was hidden last frame
+				if (hist_id_in[hist_index] == id && fabs(hist.w - view.z) < TEMPORAL_DEPTH * view.z) {
+					sumColor = mix(hist.xyz, sumColor, TEMPORAL_BLEND);
+				}
+			}
+		}
 	}
+#endif
 	
-	write_imagef(pix_buffer, (int2)(pix_X, pix_Y), VectToColor(sumColor * render_info.aa_div));
+	hist_out[pix_index] = (float4)(sumColor, depth);
+	hist_id_out[pix_index] = id;
+	write_imagef(pix_buffer, (int2)(pix_X, pix_Y), VectToColor(sumColor));
 }
@@ -1,35 +1,38 @@
-#pragma once
-#include "GLFWFuncs.h"
-#include "Colors.h"
-#include "ReadWrite.h"
-#include "Fonts.h"
-#include <assert.h>
-#include <GdiPlus.h>
-#pragma comment(lib, "gdiplus.lib")
-
-class GLGraphics
-{
-public:
-	void Initialize(GLFWwindow* pWindow, cl_context& context);
-	void AcquireBackBuff(cl_command_queue& queue);
-	void ReleaseBackBuff(cl_command_queue& queue);
-	void ToggleCursorLock();
-	void GetWindowSize(int* width, int* height);
-	void SetWindowSize(int width, int height);
-	void BeginFrame();
-	void DisplayFrame();
-private:
-	ULONG_PTR	gdiplusToken;
-	GLuint		gl_fb_id;
-	GLuint		gl_rb_id;
-	GLuint		gl_tex_id;
-	GLenum		gl_status;
-	cl_int		cl_error;
-	cl_context	cl_con;
-public:
-	GLFWwindow*	window;
-	cl_mem		gl_backBuff;
-	int			windowWidth;
-	int			windowHeight;
-	bool		cursorLocked;
+#pragma once
+#include "GLFWFuncs.h"
+#include "Colors.h"
+#include "ReadWrite.h"
+#include "Fonts.h"
+#include <assert.h>
+#include <vector>
+#include <GdiPlus.h>
+#pragma comment(lib, "gdiplus.lib")
+
+class GLGraphics
+{
+public:
+	void Initialize(GLFWwindow* pWindow, cl_context& context, UINT32 frames=1);
+	void AcquireBackBuff(cl_command_queue& queue);
+	void ReleaseBackBuff(cl_command_queue& queue);
+	void SelectBackBuff(UINT32 index);
+	void ToggleCursorLock();
+	void GetWindowSize(int* width, int* height);
+	void SetWindowSize(int width, int height);
+	void BeginFrame();
+	void DisplayFrame(UINT32 index);
+private:
+	ULONG_PTR	gdiplusToken;
+	std::vector<GLuint>	gl_fb_ids;
+	std::vector<GLuint>	gl_tex_ids;
+	std::vector<cl_mem>	gl_backBuffs;
+	UINT32		backIndex;
+	GLenum		gl_status;
+	cl_int		cl_error;
+	cl_context	cl_con;
+public:
+	GLFWwindow*	window;
+	cl_mem		gl_backBuff;
+	int			windowWidth;
+	int			windowHeight;
+	bool		cursorLocked;
 };
\ No newline at end of file
@@ -1,438 +1,1412 @@
-#include "Game.h"
-#include <time.h>
-#include <cstdlib>
-#include <string>
-#include <math.h>
-#include <iostream>
-#include <fstream>
-
-using namespace std;
-
-Game::Game(GLFWwindow* window, KeyboardServer& kServer, MouseServer& mServer)
-:
-	kbd( kServer ),
-	mouse( mServer )
-{
-	// ensure the compiler is playing nice
-	assert(sizeof(RGB32) == sizeof(cl_RGB32) && sizeof(RGB32) == 4);
-	assert(sizeof(Vec3) == sizeof(cl_float3) && sizeof(Vec3) == 16);
-	assert(sizeof(Material) == sizeof(cl_Material) && sizeof(Material) == 64);
-	assert(sizeof(Triangle) == sizeof(cl_Triangle) && sizeof(Triangle) == 64);
-	assert(sizeof(cl_SurfInfo) == 16);
-	assert(sizeof(cl_MeshInfo) == 32);
-	assert(sizeof(cl_Substance) == 32); // TODO: substance stuff
-	assert(sizeof(cl_RayIntersect) == 32);
-	assert(sizeof(cl_ObjectInfo) == 128);
-	assert(sizeof(cl_RenderInfo) == 128);
-
-	// use settings previously loaded from file
-	max_distance[0] = stof(GLOBALS::config_map["MAX_DISTANCE1"]);
-	max_distance[1] = stof(GLOBALS::config_map["MAX_DISTANCE2"]);
-	max_distance[2] = stof(GLOBALS::config_map["MAX_DISTANCE3"]);
-	max_distance[3] = stof(GLOBALS::config_map["MAX_DISTANCE4"]);
-
-	trans_depth = stoi(GLOBALS::config_map["TRANS_DEPTH"]);
-	sub_rays = stoi(GLOBALS::config_map["AA_SUB_RAYS"]);
-
-	switch (sub_rays) {
-		case 1: aaInfo = GLOBALS::AA_X1; break;
-		case 4: aaInfo = GLOBALS::AA_X4; break;
-		case 9: aaInfo = GLOBALS::AA_X9; break;
-		case 16: aaInfo = GLOBALS::AA_X16; break;
-		default:
-			string emsg = "Invalid AA level detected: "+GLOBALS::config_map["AA_SUB_RAYS"];
-			HandleFatalError(1, emsg);
-			break;
-	}
-
-	// Initialize OpenCL
-	openCL.Initialize(sub_rays, trans_depth);
-
-	// Initialize graphics manager
-	gfx.Initialize(window, openCL.context());
-
-	// load default font
-	DefFont = new Font("Data\\fonts\\GenericFont.bmp", "generic", 16, 16, 16, BLACK);
-
-	// load material properties library
-	matSet.Load("Data\\materials.mpl");
-
-	// set camera sensitivity based on settings
-	camera.sensitivity = stof(GLOBALS::config_map["MOUSE_SENSI"]);
-
-	// load objects, lights, etc, from level layout file
-	scene.LoadLevel("Data\\levels\\level_0.llf", camera, matSet, &meshSet, &textSet);
-
-	// calc useful screen info
-	widthHalf = gfx.windowWidth / 2;
-	heightHalf = gfx.windowHeight / 2;
-	widthRays = gfx.windowWidth * aaInfo.lvl;
-	heightRays = gfx.windowHeight * aaInfo.lvl;
-	heightSpan = gfx.windowHeight - 1;
-	widthSpan = gfx.windowWidth - 1;
-	pixCount = gfx.windowWidth * gfx.windowHeight;
-	rayCount = pixCount * aaInfo.lvl;
-
-	// set dimensions of local work groups
-	for (p=64; p>0; p--) {
-		n = p * 64;
-		if (n <= openCL.max_wg_size && (pixCount % n == 0)) {
-			openCL.local_range = cl::NDRange(n, 1);
-			break;
-		}
-	}
-
-	if (p == 0) {
-		string emsg = "Incompatible resolution detected: "+IntToStr(gfx.windowWidth)+"x"+IntToStr(gfx.windowHeight);
-		HandleFatalError(2, emsg);
-	}
-
-	// setup RenderInfo structure
-	//rInfo.pix_count = pixCount;
-	//rInfo.ray_count = rayCount;
-	rInfo.pixels_X = gfx.windowWidth;
-	//rInfo.pixels_Y = windHeight;
-	//rInfo.rays_X = widthRays;
-	//rInfo.rays_Y = heightRays;
-	rInfo.aa_info = aaInfo;
-	rInfo.t_depth = trans_depth;
-	//rInfo.d_time = 0.0f;
-
-	// allocate and copy to memory on GPU for material buffer
-	cl_mtrlSet = cl::Buffer(openCL.context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, sizeof(cl_Material)*matSet.count, matSet.materials);
-
-	// allocate memory on GPU for pixel buffer
-	cl_pixBuff = cl::Buffer(openCL.context, CL_MEM_READ_WRITE, sizeof(cl_RGB32)*pixCount);
-
-	// allocate memory on GPU for primary ray buffer
-	cl_rayBuff = cl::Buffer(openCL.context, CL_MEM_READ_WRITE, sizeof(cl_float4)*rayCount);
-
-	// allocate memory on GPU for ray color buffer
-	cl_cidBuff = cl::Buffer(openCL.context, CL_MEM_READ_WRITE, sizeof(cl_RGB32)*rayCount*trans_depth);
-
-	// allocate memory on GPU for intersection buffer
-	cl_ridBuff = cl::Buffer(openCL.context, CL_MEM_READ_WRITE, sizeof(cl_RayIntersect)*rayCount*trans_depth);
-
-	// copy mesh set to GPU memory
-	for (UINT32 mi=0; mi<meshSet.count; mi++) {
-		Mesh* mesh = meshSet.GetMesh(mi);
-		for (UINT32 ml=0; ml<meshSet.CountLoDs(mi); ml++) {
-			mesh[ml].CreateMemBuffer(openCL.context);
-			mesh[ml].CopyToMemBuffer(openCL.queue);
-		}
-
-	}
-	// copy texture set to GPU memory
-	for (UINT32 ti=0; ti<textSet.count; ti++) {
-		Texture* texture = textSet.GetTexture(ti);
-		for (UINT32 tl=0; tl<textSet.CountLoDs(ti); tl++) {
-			texture[tl].CreateMemBuffer(openCL.context);
-			texture[tl].CopyToMemBuffer(openCL.queue);
-		}
-	}
-}
-
-
-Game::~Game()
-{
-	// remove meshes from GPU memory
-	for (UINT32 mi=0; mi<meshSet.count; mi++) {
-		Mesh* mesh = meshSet.GetMesh(mi);
-		for (UINT32 ml=0; ml<meshSet.CountLoDs(mi); ml++) {
-			mesh[ml].DeleteMemBuffer();
-		}
-	}
-	// remove textures from GPU memory
-	for (UINT32 ti=0; ti<textSet.count; ti++) {
-		Texture* texture = textSet.GetTexture(ti);
-		for (UINT32 tl=0; tl<textSet.CountLoDs(ti); tl++) {
-			texture[tl].DeleteMemBuffer();
-		}
-	}
-}
-
-void Game::Go()
-{
-	deltaTimer.StopWatch();
-	deltaTime = deltaTimer.GetTimeMilli();
-	deltaTimer.StartWatch();
-	//gfx.BeginFrame();
-	ComposeFrame();
-	gfx.DisplayFrame();
-}
-
-void Game::HandleInput()
-{
-	// keys for left and right tilt
-	if (kbd.KeyIsPressed(GLFW_KEY_E)) {
-		camera.orientation.z -= CAMSPIN_SPEED * deltaTime;
-	} else if (kbd.KeyIsPressed(GLFW_KEY_Q)) {
-		camera.orientation.z += CAMSPIN_SPEED * deltaTime;
-	}
-
-	KeyEvent ke = kbd.ReadKey();
-	if (ke.IsPress()) {
-		switch (ke.GetCode()) {
-		case GLFW_KEY_NUM_LOCK:
-			gfx.ToggleCursorLock();
-			break;
-		default: break;
-		}
-	}
-
-	// handle mouse events
-	MouseEvent me = mouse.ReadMouse();
-	switch (me.GetType()) {
-	case MouseEvent::Move:
-		if (gfx.cursorLocked) {
-			dX = me.GetX() * camera.sensitivity * deltaTime;
-			dY = me.GetY() * camera.sensitivity * deltaTime;
-			camera.orientation.x += dY;
-			camera.orientation.y -= dX;
-			glfwSetCursorPos(gfx.window, 0.0, 0.0);
-		}
-		break;
-	case MouseEvent::WheelUp:
-		camera.foclen += 10;
-		break;
-	case MouseEvent::WheelDown:
-		camera.foclen -= 10;
-		break;
-	}
-
-	// update camera direction
-	camera.updateDirection();
-
-	// keys for global ambient light intensity
-	if (kbd.KeyIsPressed(GLFW_KEY_UP)) {
-		scene.lightSet.ambLight + 0.02f;
-		scene.lightSet.ambLight.VectMin(1.0f);
-	} else if (kbd.KeyIsPressed(GLFW_KEY_DOWN)) {
-		scene.lightSet.ambLight - 0.02f;
-		scene.lightSet.ambLight.VectMax(0.0f);
-	}
-
-	// keys for up and down movement
-	if (kbd.KeyIsPressed(GLFW_KEY_PAGE_UP)) {
-		camera.position += camera.up * (CAMMOVE_SPEED * deltaTime);
-	} else if (kbd.KeyIsPressed(GLFW_KEY_PAGE_DOWN)) {
-		camera.position -= camera.up * (CAMMOVE_SPEED * deltaTime);
-	}
-
-	// keys for forward and backward movement
-	if (kbd.KeyIsPressed(GLFW_KEY_W)) {
-		camera.position += camera.forward * (CAMMOVE_SPEED * deltaTime);
-	} else if (kbd.KeyIsPressed(GLFW_KEY_S)) {
-		camera.position -= camera.forward * (CAMMOVE_SPEED * deltaTime);
-	}
-
-	// keys for right and left movement
-	if (kbd.KeyIsPressed(GLFW_KEY_D)) {
-		camera.position += camera.right * (CAMMOVE_SPEED * deltaTime);
-	} else if (kbd.KeyIsPressed(GLFW_KEY_A)) {
-		camera.position -= camera.right * (CAMMOVE_SPEED * deltaTime);
-	}	
-}
-
-void Game::BeginActions()
-{
-	// calculate bottom left position of virtual screen
-	blpRay = (camera.forward * camera.foclen).
-			 VectSub(camera.right * widthHalf).
-			 VectSub(camera.up * heightHalf);
-
-	// save camera info to RenderInfo structure
-	rInfo.cam_foc = camera.foclen;
-	rInfo.cam_apt = camera.aptrad;
-	rInfo.cam_pos = camera.position.toFloat3();
-	rInfo.cam_ori = camera.orientation.toFloat3();
-	rInfo.cam_fwd = camera.forward.toFloat3();
-	rInfo.cam_rgt = camera.right.toFloat3();
-	rInfo.cam_up = camera.up.toFloat3();
-	rInfo.bl_ray = blpRay.toFloat3();
-	//rInfo.d_time = deltaTime;
-
-	// compute primary rays
-	openCL.CR_Kernel.setArg(0, cl_rayBuff);
-	openCL.CR_Kernel.setArg(1, rInfo);
-	openCL.RunKernel0(gfx.windowWidth, gfx.windowHeight);
-	openCL.queue.finish();
-}
-
-void Game::ComputeStage1(Object& object)
-{
-	// apply motion if non-static object
-	object.UpdateObject(deltaTime);
-
-	// check if object is visible
-	if (!object.isVisible) { return; }
-
-	// get object position relative to cam
-	objPos = camera.PointRelCam(object.position);
-
-	// get minimum distance to object bounding sphere
-	objDist = max(camera.position.VectDist(object.position) - object.radius, 0.0f);
-
-	// skip objects beyond max view distance
-	switch (object.maxDist) {
-		case 0: break;
-		case 1: if (objDist > max_distance[0]) { return; } break;
-		case 2: if (objDist > max_distance[1]) { return; } break;
-		case 3: if (objDist > max_distance[2]) { return; } break;
-		case 4: if (objDist > max_distance[3]) { return; } break;
-	}
-
-	// TODO: deal with lights
-
-	// check if object is behind camera
-	if (objPos.z+object.radius <= 0.0f) { return; }
-
-	// works best when mesh & texture detail halves with each level of detail
-	object.SetLoD(max(sqrt(objPos.VectMag()/camera.foclen)-1.0f, 0.0f));
-
-	maxX = maxY = 0.0f;
-	minX = minY = FLT_MAX;
-
-	// check if we should update object bounding box cache
-	if (!object.bCached) {
-		for (p=0; p<8; p++) {
-			object.bbvCache[p] = object.PointRelWorld(object.boundBox[p]);
-			object.bCached = true;
-		}
-	}
-
-	// transform points on bounding box to screen coordinates
-	for (p=0; p<8; p++) {
-
-		// get corner of bounding box relative to cam
-		bboxVert = camera.PointRelCam(object.bbvCache[p]);
-
-		// map corner vertex onto screen coords
-		if (bboxVert.z < 0.0f) {
-			// fix coordinates for points behind cam
-			coords[p].x = (bboxVert.x < 0.0f) ? -1.0f : gfx.windowWidth;
-			coords[p].y = (bboxVert.y < 0.0f) ? -1.0f : gfx.windowHeight;
-		} else {
-			coords[p].x = widthHalf + (bboxVert.x / bboxVert.z) * camera.foclen;
-			coords[p].y = heightHalf + (bboxVert.y / bboxVert.z) * camera.foclen;
-		}
-
-		// get top left and bottom right coordinates
-		minX = min(coords[p].x, minX);
-		maxX = max(coords[p].x, maxX);
-		minY = min(coords[p].y, minY);
-		maxY = max(coords[p].y, maxY);
-	}
-
-	// cull objects not in field of view
-	if (((minX < 0.0f && maxX < 0.0f) || (minX > widthSpan && maxX > widthSpan))
-	|| ((minY < 0.0f && maxY < 0.0f) || (minY > widthSpan && maxY > widthSpan))) 
-	{ return; }
-
-	// clip coordinates if outside screen
-	minX = min(max(minX, 0.0f), widthSpan);
-	minY = min(max(minY, 0.0f), heightSpan);
-	maxX = min(maxX, widthSpan);
-	maxY = min(maxY, heightSpan);
-
-	// calc rays needed for each axis of 2D BB
-	bbsX = maxX - minX + 1;
-	bbsY = maxY - minY + 1;
-
-	// check if object is analytical sphere
-	if (object.type == -1) {
-
-		/*CS_Kernel.setArg(0, cl_rayBuff);
-		openCL.CS_Kernel.setArg(1, cl_ridBuff);
-		openCL.CS_Kernel.setArg(2, cl_cidBuff);
-		openCL.CS_Kernel.setArg(3, object.info);
-		openCL.CS_Kernel.setArg(4, rInfo);
-
-		openCL.queue.enqueueNDRangeKernel(CS_Kernel, cl::NDRange((size_t)minX, (size_t)minY), cl::NDRange(bbsX, bbsY), local_range);
-		openCL.queue.finish();*/
-
-	} else {
-
-		Mesh* pMesh = object.GetMesh();
-		Texture* pTex = object.GetTexture();
-
-		cl_MeshInfo meshInfo = pMesh->info;
-		cl_SurfInfo surfInfo = pTex->surface.info;
-
-		openCL.CT_Kernel.setArg(0, cl_rayBuff);
-		openCL.CT_Kernel.setArg(1, cl_ridBuff);
-		openCL.CT_Kernel.setArg(2, cl_cidBuff);
-		openCL.CT_Kernel.setArg(3, cl_mtrlSet);
-
-		openCL.CT_Kernel.setArg(4, *(pMesh->vertBuff));
-		openCL.CT_Kernel.setArg(5, *(pMesh->triBuff));
-		openCL.CT_Kernel.setArg(6, *(pTex->texBuff));
-
-		if (pTex->hasNormMap) {
-			openCL.CT_Kernel.setArg(7, *(pTex->normBuff));
-		} else {
-			openCL.CT_Kernel.setArg(7, NULL);
-		}
-
-		openCL.CT_Kernel.setArg(8, object.info);
-		openCL.CT_Kernel.setArg(9, meshInfo);
-		openCL.CT_Kernel.setArg(10, surfInfo);
-		openCL.CT_Kernel.setArg(11, rInfo);
-
-		// send rays through area covered by 2D bounding box
-		openCL.RunKernel1(minX, minY, bbsX, bbsY);
-		openCL.queue.finish();
-	}
-}
-
-void Game::ComputeStage2()
-{
-	// compute final pixel colors
-	openCL.CL_Kernel.setArg(0, cl_rayBuff);
-	openCL.CL_Kernel.setArg(1, cl_cidBuff);
-	openCL.CL_Kernel.setArg(2, gfx.gl_backBuff);
-	openCL.CL_Kernel.setArg(3, rInfo);
-	openCL.RunKernel2(gfx.windowWidth, gfx.windowHeight);
-	openCL.queue.finish();
-}
-
-void Game::RenderScene()
-{
-	// loop through all object sets
-	for (s = 0; s < scene.objectSets.count; s++) 
-	{
-		// get reference to current object set
-		ObjectSet& objSet = *(scene.objectSets.GetSetByIndex(s));
-		
-		// loop through all objects in this set
-		for (o = 0; o < objSet.count; o++) 
-		{
-			// do primary ray computations
-			ComputeStage1(*(objSet.ObjectByIndex(o)));
-		}
-	}
-
-	// lighting computations
-	ComputeStage2();
-}
-
-void Game::ComposeFrame()
-{
-	// TODO: refactor code for pixel-blocks
-	// TODO: use OpenCL image types
-
-	// handle keyboard/mouse actions
-	HandleInput();
-
-	// reset/update some stuff
-	BeginActions();
-
-	// give OCL control of OGL framebuffer
-	gfx.AcquireBackBuff(openCL.queue());
-
-	// render the 3D scene using OCL
-	RenderScene();
-
-	// make OCL release control of OGL memory
-	gfx.ReleaseBackBuff(openCL.queue());
+#include "Game.h"
+#include <time.h>
+#include <cstdlib>
+#include <string>
+#include <math.h>
+#include <iostream>
+#include <fstream>
+
+using namespace std;
+
+Game::Game(GLFWwindow* window, KeyboardServer& kServer, MouseServer& mServer)
+:
+	kbd( kServer ),
+	mouse( mServer )
+{
+	// ensure the compiler is playing nice
+	assert(sizeof(RGB32) == sizeof(cl_RGB32) && sizeof(RGB32) == 4);
+	assert(sizeof(Vec3) == sizeof(cl_float3) && sizeof(Vec3) == 16);
+	assert(sizeof(Material) == sizeof(cl_Material) && sizeof(Material) == 64);
+	assert(sizeof(Triangle) == sizeof(cl_Triangle) && sizeof(Triangle) == 64);
+	assert(sizeof(cl_PackedTri) == 32);
+	assert(sizeof(cl_SurfInfo) == 16);
+	assert(sizeof(cl_TexInfo) == 32);
+	assert(sizeof(cl_MeshInfo) == 48);
+	assert(sizeof(cl_Substance) == 32); // TODO: substance stuff
+	assert(sizeof(cl_RayIntersect) == 32);
+	assert(sizeof(cl_Matrix3x4) == sizeof(Mat3x4) && sizeof(Mat3x4) == 48);
+	assert(sizeof(cl_ObjectInfo) == sizeof(Object::info) && sizeof(cl_ObjectInfo) == 224);
+	assert(sizeof(cl_RenderInfo) == 192);
+	assert(sizeof(cl_Instance) == 368);
+	assert(sizeof(cl_Light) == 64);
+	assert(sizeof(cl_ClusterInfo) == 32);
+	assert(sizeof(cl_SecRay) == 64);
+
+	// use settings previously loaded from file
+	max_distance[0] = stof(GLOBALS::config_map["MAX_DISTANCE1"]);
+	max_distance[1] = stof(GLOBALS::config_map["MAX_DISTANCE2"]);
+	max_distance[2] = stof(GLOBALS::config_map["MAX_DISTANCE3"]);
+	max_distance[3] = stof(GLOBALS::config_map["MAX_DISTANCE4"]);
+
+	trans_depth = stoi(GLOBALS::config_map["TRANS_DEPTH"]);
+	sub_rays = stoi(GLOBALS::config_map["AA_SUB_RAYS"]);
+	aa_refine = min(max(stoi(GLOBALS::config_map["AA_REFINE"]), 0), 100);
+	temporal_aa = stoi(GLOBALS::config_map["TEMPORAL_AA"]) != 0;
+	mesh_bvh = stoi(GLOBALS::config_map["MESH_BVH"]) != 0;
+	tri_tiling = stoi(GLOBALS::config_map["TRI_TILING"]) != 0;
+	vis_buffer = stoi(GLOBALS::config_map["VIS_BUFFER"]) != 0;
+	lighting = stoi(GLOBALS::config_map["LIGHTING"]) != 0;
+	refl_depth = stoi(GLOBALS::config_map["REFL_DEPTH"]);
+	mesh_quant = stoi(GLOBALS::config_map["MESH_QUANT"]) != 0;
+	tex_compress = stoi(GLOBALS::config_map["TEX_COMPRESS"]) != 0;
+	tex_compare = stoi(GLOBALS::config_map["TEX_COMPARE"]) != 0;
+	show_bf = stoi(GLOBALS::config_map["SHOW_BF"]) != 0;
+	fast_math = stoi(GLOBALS::config_map["FAST_MATH"]) != 0;
+	frames_in_flight = max(stoi(GLOBALS::config_map["FRAMES_IN_FLIGHT"]), 1);
+	max_light_dist = stof(GLOBALS::config_map["MAX_LIGHT_DIST"]);
+	max_shadow_dist = stof(GLOBALS::config_map["MAX_CSHAD_DIST"]);
+	render_mode = stoi(GLOBALS::config_map["RENDER_MODE"]);
+	persistGroups = stoi(GLOBALS::config_map["PERSIST_GROUPS"]);
+	tileSize = stoi(GLOBALS::config_map["TILE_SIZE"]);
+
+	switch (sub_rays) {
+		case 1: aaInfo = GLOBALS::AA_X1; break;
+		case 4: aaInfo = GLOBALS::AA_X4; break;
+		case 9: aaInfo = GLOBALS::AA_X9; break;
+		case 16: aaInfo = GLOBALS::AA_X16; break;
+		default:
+			string emsg = "Invalid AA level detected: "+GLOBALS::config_map["AA_SUB_RAYS"];
+			HandleFatalError(1, emsg);
+			break;
+	}
+
+	// sub-rays are only traced for edge pixels, which needs the ray queue of the wavefront kernels
+	if (render_mode != RENDER_WAVEFRONT || aaInfo.lvl == 1) { aa_refine = 0; }
+
+	// resolving hits needs the shared pools so it only works with the scene kernels
+	vis_buffer = vis_buffer && render_mode != RENDER_OBJECTS;
+
+	// reprojection needs the instance ids of the visibility planes and one final color per pixel
+	temporal_aa = temporal_aa && vis_buffer && aa_refine == 0;
+
+	// load material properties library
+	matSet.Load("Data\\materials.mpl");
+
+	// reflection rays are traced against the top level hierarchy and only matter if something reflects
+	bool reflective = false;
+	for (UINT32 mi = 0; mi < matSet.count; mi++) {
+		if (matSet.materials[mi].reflectivity > 0.0f) { reflective = true; }
+	}
+	if (render_mode == RENDER_OBJECTS || !reflective) { refl_depth = 0; }
+
+	// set camera sensitivity based on settings
+	camera.sensitivity = stof(GLOBALS::config_map["MOUSE_SENSI"]);
+
+	// load objects, lights, etc, from level layout file
+	scene.LoadLevel("Data\\levels\\level_0.llf", camera, matSet, &meshSet, &textSet);
+
+	// kernel features are selected when the program is built, fixed loop counts let the compiler unroll them
+	string clOptions = "-D AA_LVL="+IntToStr(aaInfo.lvl)+" -D AA_DIM="+IntToStr(aaInfo.dim)+" -D T_DEPTH="+IntToStr(trans_depth)+" ";
+	if (show_bf) { clOptions += "-D SHOW_BF=1 "; }
+	if (fast_math) { clOptions += "-cl-fast-relaxed-math "; }
+	if (mesh_bvh) { clOptions += "-D MESH_BVH "; }
+	if (tri_tiling) { clOptions += "-D TRI_TILING "; }
+
+	if (vis_buffer) { clOptions += "-D VIS_BUFFER "; }
+
+	// shadow rays are traced against the top level hierarchy so they also need the scene kernels
+	lighting = lighting && render_mode != RENDER_OBJECTS;
+	if (lighting) { clOptions += "-D LIGHTING "; }
+
+	// vertices and triangles are unpacked from 16 bit values as they are read,
+	// triangles keep 32 bit indexes if any mesh has more vertices than 16 bits can reach
+	if (mesh_quant) { clOptions += "-D MESH_QUANT "; }
+	short_index = mesh_quant && meshSet.ShortIndexes();
+	if (short_index) { clOptions += "-D SHORT_INDEX "; }
+	if (mesh_quant && !short_index) { cout << "Meshes over 65536 vertices, triangles keep 32 bit indexes\n"; }
+
+	// textures are decoded from 4x4 blocks instead of sampled from an image
+	if (tex_compress) { clOptions += "-D TEX_BC "; }
+
+	// Initialize OpenCL
+	openCL.Initialize(sub_rays, trans_depth, clOptions, frames_in_flight, aa_refine > 0, tex_compare);
+
+	// Initialize graphics manager
+	gfx.Initialize(window, openCL.context(), frames_in_flight);
+	frameStages.resize(frames_in_flight);
+
+	// load default font
+	DefFont = new Font("Data\\fonts\\GenericFont.bmp", "generic", 16, 16, 16, BLACK);
+
+	// calc useful screen info
+	widthHalf = gfx.windowWidth / 2;
+	heightHalf = gfx.windowHeight / 2;
+	widthRays = gfx.windowWidth * aaInfo.lvl;
+	heightRays = gfx.windowHeight * aaInfo.lvl;
+	heightSpan = gfx.windowHeight - 1;
+	widthSpan = gfx.windowWidth - 1;
+	pixCount = gfx.windowWidth * gfx.windowHeight;
+	rayCount = pixCount * aaInfo.lvl;
+
+	// with adaptive anti-aliasing the ray buffers hold either one ray per pixel or the refined pixels
+	refineCap = max((pixCount / 100) * aa_refine, (UINT32)1);
+	if (aa_refine > 0) { rayCount = max(pixCount, refineCap * aaInfo.lvl); }
+
+	// set dimensions of local work groups
+	for (p=64; p>0; p--) {
+		n = p * 64;
+		if (n <= openCL.max_wg_size && (pixCount % n == 0)) {
+			openCL.local_range = cl::NDRange(n, 1);
+			break;
+		}
+	}
+
+	if (p == 0) {
+		string emsg = "Incompatible resolution detected: "+IntToStr(gfx.windowWidth)+"x"+IntToStr(gfx.windowHeight);
+		HandleFatalError(2, emsg);
+	}
+
+	// setup RenderInfo structure
+	//rInfo.pix_count = pixCount;
+	rInfo.ray_count = rayCount;
+	rInfo.pixels_X = gfx.windowWidth;
+	//rInfo.pixels_Y = windHeight;
+	//rInfo.rays_X = widthRays;
+	//rInfo.rays_Y = heightRays;
+	rInfo.aa_info = aaInfo;
+	rInfo.t_depth = trans_depth;
+	rInfo.jitter_X = 0.0f;
+	rInfo.jitter_Y = 0.0f;
+	//rInfo.d_time = 0.0f;
+	prevInfo = rInfo;
+	histIndex = 0;
+	jitterIndex = 0;
+
+	// allocate and copy to memory on GPU for material buffer
+	cl_mtrlSet = cl::Buffer(openCL.context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, sizeof(cl_Material)*matSet.count, matSet.materials);
+
+	// allocate memory on GPU for pixel buffer
+	cl_pixBuff = cl::Buffer(openCL.context, CL_MEM_READ_WRITE, sizeof(cl_RGB32)*pixCount);
+
+	// allocate memory on GPU for primary ray buffer
+	cl_rayBuff = cl::Buffer(openCL.context, CL_MEM_READ_WRITE, sizeof(cl_float4)*rayCount);
+
+	// allocate memory on GPU for ray color planes (one per layer)
+	cl_cidBuff = cl::Buffer(openCL.context, CL_MEM_READ_WRITE, sizeof(cl_RGB32)*rayCount*trans_depth);
+
+	// allocate memory on GPU for intersection planes (point, normal, depth, material)
+	// or visibility planes (barycentrics, depth, object id, triangle id)
+	if (vis_buffer) {
+		cl_ridBuff = cl::Buffer(openCL.context, CL_MEM_READ_WRITE, (sizeof(cl_float2)+sizeof(cl_float)+sizeof(cl_uint)*2)*rayCount*trans_depth);
+	} else {
+		cl_ridBuff = cl::Buffer(openCL.context, CL_MEM_READ_WRITE, (sizeof(cl_float3)*2+sizeof(cl_float)+sizeof(cl_uint))*rayCount*trans_depth);
+	}
+
+	// allocate memory on GPU for persistent work counter
+	cl_workCount = cl::Buffer(openCL.context, CL_MEM_READ_WRITE, sizeof(cl_uint));
+	persistGroups *= openCL.max_cu_count;
+	workStart = 0;
+	frameCount = 0;
+	statsCount = 0;
+
+	if (render_mode == RENDER_SCENE || render_mode == RENDER_WAVEFRONT || render_mode == RENDER_TILED) {
+
+		// copy mesh set into shared GPU pools
+		meshSet.CreatePoolBuffers(openCL.context, mesh_quant, short_index);
+		meshSet.CopyToPoolBuffers(openCL.queue);
+
+		// every object in the level can be an instance
+		maxInstances = 1;
+		for (s = 0; s < scene.objectSets.count; s++) {
+			maxInstances += scene.objectSets.GetSetByIndex(s)->count;
+		}
+
+		instances.reserve(maxInstances);
+		instBounds.reserve(maxInstances);
+		outInstances.reserve(maxInstances);
+		outBounds.reserve(maxInstances);
+		instBoxes.reserve(maxInstances);
+
+		// allocate memory on GPU for instances and top level hierarchy
+		cl_instBuff = cl::Buffer(openCL.context, CL_MEM_READ_ONLY, sizeof(cl_Instance)*maxInstances);
+		cl_tlasBuff = cl::Buffer(openCL.context, CL_MEM_READ_ONLY, sizeof(cl_BVHNode)*maxInstances*2);
+		cl_tidxBuff = cl::Buffer(openCL.context, CL_MEM_READ_ONLY, sizeof(cl_uint)*maxInstances);
+
+		// shadow and reflection rays use a second hierarchy which also holds the objects off screen
+		cl_wlasBuff = cl::Buffer(openCL.context, CL_MEM_READ_ONLY, sizeof(cl_BVHNode)*maxInstances*2);
+		cl_widxBuff = cl::Buffer(openCL.context, CL_MEM_READ_ONLY, sizeof(cl_uint)*maxInstances);
+
+		// allocate memory on GPU for every light in the level
+		UINT32 maxLights = scene.lightSet.el_count + scene.lightSet.fl_count;
+		lightInfo.reserve(maxLights);
+		cl_lightBuff = cl::Buffer(openCL.context, CL_MEM_READ_ONLY, sizeof(cl_Light)*max(maxLights, (UINT32)1));
+
+		// screen tiles split into depth slices, each with a short list of falloff lights
+		clusterInfo.tiles_X = (gfx.windowWidth + CLUSTER_SIZE - 1) / CLUSTER_SIZE;
+		clusterInfo.tiles_Y = (gfx.windowHeight + CLUSTER_SIZE - 1) / CLUSTER_SIZE;
+		clusterInfo.tile_size = CLUSTER_SIZE;
+		clusterInfo.slices = CLUSTER_SLICES;
+		clusterInfo.near_z = CLUSTER_NEAR;
+		clusterInfo.log_scale = CLUSTER_SLICES / log(max_distance[3] / CLUSTER_NEAR);
+		clusterInfo.light_first = 0;
+		clusterInfo.light_count = 0;
+		clusterCount = clusterInfo.tiles_X * clusterInfo.tiles_Y * clusterInfo.slices;
+
+		cl_clusterLights = cl::Buffer(openCL.context, CL_MEM_READ_WRITE, sizeof(cl_uint)*clusterCount*CLUSTER_LIGHTS);
+		cl_clusterCounts = cl::Buffer(openCL.context, CL_MEM_READ_WRITE, sizeof(cl_uint)*clusterCount);
+
+		// clusters which ran out of room and the lights they dropped
+		cl_clusterOverflow = cl::Buffer(openCL.context, CL_MEM_READ_WRITE, sizeof(cl_uint)*2);
+		clusterFull = clusterDrops = 0;
+		lightFrames = 0;
+
+		if (render_mode == RENDER_WAVEFRONT || refl_depth > 0) {
+
+			// allocate memory on GPU for ray queues and compaction
+			cl_rayQueue[0] = cl::Buffer(openCL.context, CL_MEM_READ_WRITE, sizeof(cl_uint)*rayCount);
+			cl_rayQueue[1] = cl::Buffer(openCL.context, CL_MEM_READ_WRITE, sizeof(cl_uint)*rayCount);
+			cl_rayAlive = cl::Buffer(openCL.context, CL_MEM_READ_WRITE, sizeof(cl_uint)*rayCount);
+			cl_rayScan = cl::Buffer(openCL.context, CL_MEM_READ_WRITE, sizeof(cl_uint)*rayCount);
+			cl_queueCount = cl::Buffer(openCL.context, CL_MEM_READ_WRITE, sizeof(cl_uint));
+		}
+
+		if (aa_refine > 0) {
+
+			// allocate memory on GPU for the list of pixels given sub-rays, every pixel may be flagged
+			cl_refineList = cl::Buffer(openCL.context, CL_MEM_READ_WRITE, sizeof(cl_uint)*pixCount);
+			cl_refineCount = cl::Buffer(openCL.context, CL_MEM_READ_WRITE, sizeof(cl_uint));
+		}
+
+		if (temporal_aa) {
+
+			// allocate memory on GPU for the color and depth of the last two frames, nothing matches the first frame
+			for (n = 0; n < 2; n++) {
+				cl_histColor[n] = cl::Buffer(openCL.context, CL_MEM_READ_WRITE, sizeof(cl_float4)*pixCount);
+				cl_histId[n] = cl::Buffer(openCL.context, CL_MEM_READ_WRITE, sizeof(cl_uint)*pixCount);
+				openCL.queue.enqueueFillBuffer(cl_histId[n], (cl_uint)0xFFFFFFFF, 0, sizeof(cl_uint)*pixCount);
+			}
+		}
+
+		if (refl_depth > 0) {
+
+			// allocate memory on GPU for the reflection ray of each primary ray
+			cl_secRays = cl::Buffer(openCL.context, CL_MEM_READ_WRITE, sizeof(cl_SecRay)*rayCount);
+		}
+
+		if (render_mode == RENDER_TILED) {
+
+			if (tileSize == 0) {
+				HandleFatalError(4, "Invalid tile size: "+GLOBALS::config_map["TILE_SIZE"]);
+			}
+
+			tilesX = (gfx.windowWidth + tileSize - 1) / tileSize;
+			tilesY = (gfx.windowHeight + tileSize - 1) / tileSize;
+			tileCount = tilesX * tilesY;
+
+			// allocate memory on GPU for per-tile object lists, sized for every object covering every tile
+			cl_instBoxes = cl::Buffer(openCL.context, CL_MEM_READ_ONLY, sizeof(cl_uint4)*maxInstances);
+			cl_tileCounts = cl::Buffer(openCL.context, CL_MEM_READ_WRITE, sizeof(cl_uint)*tileCount);
+			cl_tileOffsets = cl::Buffer(openCL.context, CL_MEM_READ_WRITE, sizeof(cl_uint)*tileCount);
+			cl_tileFill = cl::Buffer(openCL.context, CL_MEM_READ_WRITE, sizeof(cl_uint)*tileCount);
+			cl_tileRefs = cl::Buffer(openCL.context, CL_MEM_READ_WRITE, sizeof(cl_uint)*tileCount*maxInstances);
+		}
+
+		if (render_mode == RENDER_WAVEFRONT || render_mode == RENDER_TILED || refl_depth > 0) {
+
+			// each scan level needs a buffer for its work group totals
+			for (n = rayCount; n > 1 || cl_scanSums.empty();) {
+				n = (n + WAVE_SCAN_SIZE - 1) / WAVE_SCAN_SIZE;
+				cl_scanSums.push_back(cl::Buffer(openCL.context, CL_MEM_READ_WRITE, sizeof(cl_uint)*n));
+			}
+		}
+
+	} else if (render_mode == RENDER_OBJECTS) {
+
+		// copy mesh set to GPU memory
+		for (UINT32 mi=0; mi<meshSet.count; mi++) {
+			Mesh* mesh = meshSet.GetMesh(mi);
+			for (UINT32 ml=0; ml<meshSet.CountLoDs(mi); ml++) {
+				mesh[ml].CreateMemBuffer(openCL.context, mesh_quant, short_index);
+				mesh[ml].CopyToMemBuffer(openCL.queue);
+			}
+
+		}
+		// analytical spheres are gathered each frame and traced in one launch
+		UINT32 maxSpheres = 1;
+		for (s = 0; s < scene.objectSets.count; s++) {
+			ObjectSet& objSet = *(scene.objectSets.GetSetByIndex(s));
+			for (o = 0; o < objSet.count; o++) {
+				if (objSet.ObjectByIndex(o)->type == -1) { maxSpheres++; }
+			}
+		}
+
+		sphereInfo.reserve(maxSpheres);
+		sphereBounds.reserve(maxSpheres);
+
+		// allocate memory on GPU for spheres and the hierarchy over them
+		cl_sphBuff = cl::Buffer(openCL.context, CL_MEM_READ_ONLY, sizeof(cl_ObjectInfo)*maxSpheres);
+		cl_sbvhBuff = cl::Buffer(openCL.context, CL_MEM_READ_ONLY, sizeof(cl_BVHNode)*maxSpheres*2);
+		cl_sidxBuff = cl::Buffer(openCL.context, CL_MEM_READ_ONLY, sizeof(cl_uint)*maxSpheres);
+
+		// copy normal maps to GPU memory
+		for (UINT32 ti=0; ti<textSet.count; ti++) {
+			Texture* texture = textSet.GetTexture(ti);
+			for (UINT32 tl=0; tl<textSet.CountLoDs(ti); tl++) {
+				texture[tl].CreateMemBuffer(openCL.context);
+				texture[tl].CopyToMemBuffer(openCL.queue);
+			}
+		}
+
+	} else {
+		HandleFatalError(3, "Invalid render mode: "+GLOBALS::config_map["RENDER_MODE"]);
+	}
+
+	// every render mode samples colors from the texture pool
+	textSet.CreatePoolBuffers(openCL.context, tex_compress);
+	textSet.CopyToPoolBuffers(openCL.queue);
+	if (tex_compress && tex_compare) { textSet.ReportCompression(); }
+
+	// reserve world space vertices for each object, the hierarchy works in object space instead
+	UINT32 wvTotal = 0, wvMax = 0;
+	if (!mesh_bvh) {
+		for (s = 0; s < scene.objectSets.count; s++) {
+			ObjectSet& objSet = *(scene.objectSets.GetSetByIndex(s));
+			for (o = 0; o < objSet.count; o++) {
+				Object& object = *(objSet.ObjectByIndex(o));
+				if (object.type == -1 || object.meshLods == 0) { continue; }
+				// any LoD may be cached here so make room for the largest
+				object.wvOffset = wvTotal;
+				for (UINT32 ml = 0; ml < object.meshLods; ml++) {
+					object.SetMeshLoD(ml);
+					wvMax = max(wvMax, object.GetMesh()->vCount);
+				}
+				object.SetMeshLoD(0);
+				wvTotal += wvMax;
+				wvMax = 0;
+			}
+		}
+	}
+
+	// allocate memory on GPU for world space vertex cache
+	cl_wvrtPool = cl::Buffer(openCL.context, CL_MEM_READ_WRITE, sizeof(cl_float3)*max(wvTotal, (UINT32)1));
+}
+
+
+Game::~Game()
+{
+	// remove meshes from GPU memory
+	for (UINT32 mi=0; mi<meshSet.count; mi++) {
+		Mesh* mesh = meshSet.GetMesh(mi);
+		for (UINT32 ml=0; ml<meshSet.CountLoDs(mi); ml++) {
+			mesh[ml].DeleteMemBuffer();
+		}
+	}
+	// remove textures from GPU memory
+	for (UINT32 ti=0; ti<textSet.count; ti++) {
+		Texture* texture = textSet.GetTexture(ti);
+		for (UINT32 tl=0; tl<textSet.CountLoDs(ti); tl++) {
+			texture[tl].DeleteMemBuffer();
+		}
+	}
+	// remove shared pools from GPU memory
+	meshSet.DeletePoolBuffers();
+	textSet.DeletePoolBuffers();
+}
+
+void Game::Go()
+{
+	deltaTimer.StopWatch();
+	deltaTime = deltaTimer.GetTimeMilli();
+	deltaTimer.StartWatch();
+	//gfx.BeginFrame();
+	ComposeFrame();
+
+	// show the oldest frame so the newer ones can keep the device busy
+	UINT32 shown = openCL.OldestFrame();
+	if (!openCL.WaitFrame(shown)) { return; }
+	gfx.DisplayFrame(shown);
+
+	// frame times to compare compressed and raw texture pools, taken from the device timestamps
+	// of the finished frame so the host never waits for the queue to drain
+	if (tex_compare) {
+		frameTimer.AddFrame(openCL.FrameTime(shown));
+		if (++statsCount % FRAME_STATS_FRAMES == 0) {
+			cout << string(tex_compress ? "Compressed" : "Raw")+" textures, frame ms avg: "+DblToStr(frameTimer.GetAvg());
+			cout << ", min: "+DblToStr(frameTimer.GetMin())+", max: "+DblToStr(frameTimer.GetMax())+"\n";
+		}
+	}
+}
+
+void Game::HandleInput()
+{
+	// keys for left and right tilt
+	if (kbd.KeyIsPressed(GLFW_KEY_E)) {
+		camera.orientation.z -= CAMSPIN_SPEED * deltaTime;
+	} else if (kbd.KeyIsPressed(GLFW_KEY_Q)) {
+		camera.orientation.z += CAMSPIN_SPEED * deltaTime;
+	}
+
+	KeyEvent ke = kbd.ReadKey();
+	if (ke.IsPress()) {
+		switch (ke.GetCode()) {
+		case GLFW_KEY_NUM_LOCK:
+			gfx.ToggleCursorLock();
+			break;
+		default: break;
+		}
+	}
+
+	// handle mouse events
+	MouseEvent me = mouse.ReadMouse();
+	switch (me.GetType()) {
+	case MouseEvent::Move:
+		if (gfx.cursorLocked) {
+			dX = me.GetX() * camera.sensitivity * deltaTime;
+			dY = me.GetY() * camera.sensitivity * deltaTime;
+			camera.orientation.x += dY;
+			camera.orientation.y -= dX;
+			glfwSetCursorPos(gfx.window, 0.0, 0.0);
+		}
+		break;
+	case MouseEvent::WheelUp:
+		camera.foclen += 10;
+		break;
+	case MouseEvent::WheelDown:
+		camera.foclen -= 10;
+		break;
+	}
+
+	// update camera direction
+	camera.updateDirection();
+
+	// keys for global ambient light intensity
+	if (kbd.KeyIsPressed(GLFW_KEY_UP)) {
+		scene.lightSet.ambLight + 0.02f;
+		scene.lightSet.ambLight.VectMin(1.0f);
+	} else if (kbd.KeyIsPressed(GLFW_KEY_DOWN)) {
+		scene.lightSet.ambLight - 0.02f;
+		scene.lightSet.ambLight.VectMax(0.0f);
+	}
+
+	// keys for up and down movement
+	if (kbd.KeyIsPressed(GLFW_KEY_PAGE_UP)) {
+		camera.position += camera.up * (CAMMOVE_SPEED * deltaTime);
+	} else if (kbd.KeyIsPressed(GLFW_KEY_PAGE_DOWN)) {
+		camera.position -= camera.up * (CAMMOVE_SPEED * deltaTime);
+	}
+
+	// keys for forward and backward movement
+	if (kbd.KeyIsPressed(GLFW_KEY_W)) {
+		camera.position += camera.forward * (CAMMOVE_SPEED * deltaTime);
+	} else if (kbd.KeyIsPressed(GLFW_KEY_S)) {
+		camera.position -= camera.forward * (CAMMOVE_SPEED * deltaTime);
+	}
+
+	// keys for right and left movement
+	if (kbd.KeyIsPressed(GLFW_KEY_D)) {
+		camera.position += camera.right * (CAMMOVE_SPEED * deltaTime);
+	} else if (kbd.KeyIsPressed(GLFW_KEY_A)) {
+		camera.position -= camera.right * (CAMMOVE_SPEED * deltaTime);
+	}	
+}
+
+void Game::BeginActions()
+{
+	// calculate bottom left position of virtual screen
+	blpRay = (camera.forward * camera.foclen).
+			 VectSub(camera.right * widthHalf).
+			 VectSub(camera.up * heightHalf);
+
+	// rebuild camera matrix after movement
+	camera.updateMatrix();
+
+	// save camera info to RenderInfo structure
+	rInfo.cam_foc = camera.foclen;
+	rInfo.cam_apt = camera.aptrad;
+	rInfo.cam_pos = camera.position.toFloat3();
+	rInfo.cam_ori = camera.orientation.toFloat3();
+	rInfo.cam_fwd = camera.forward.toFloat3();
+	rInfo.cam_rgt = camera.right.toFloat3();
+	rInfo.cam_up = camera.up.toFloat3();
+	rInfo.bl_ray = blpRay.toFloat3();
+	rInfo.cam_mat = camera.viewMat.matrix;
+	//rInfo.d_time = deltaTime;
+
+	// the first adaptive pass traces one ray per pixel
+	rInfo.ray_count = (aa_refine > 0) ? pixCount : rayCount;
+
+	// move the rays inside their sub-pixel cell each frame so the temporal pass accumulates new samples
+	if (temporal_aa) {
+		jitterIndex = (jitterIndex + 1) % TEMPORAL_JITTER;
+		rInfo.jitter_X = (Halton(jitterIndex + 1, 2) - 0.5f) / aaInfo.dim;
+		rInfo.jitter_Y = (Halton(jitterIndex + 1, 3) - 0.5f) / aaInfo.dim;
+	}
+
+	// compute primary rays
+	openCL.CR_Kernel.setArg(0, cl_rayBuff);
+	openCL.CR_Kernel.setArg(1, rInfo);
+	openCL.RunKernel0(gfx.windowWidth, gfx.windowHeight);
+}
+
+bool Game::PrepareObject(Object& object)
+{
+	return ObjectInRange(object) && ObjectOnScreen(object);
+}
+
+bool Game::ObjectInRange(Object& object)
+{
+	// apply motion if non-static object
+	object.UpdateObject(deltaTime);
+
+	// check if object is visible
+	if (!object.isVisible) { return false; }
+
+	// get minimum distance to object bounding sphere
+	float camDist = camera.position.VectDist(object.position);
+	objDist = max(camDist - object.radius, 0.0f);
+
+	// skip objects beyond max view distance
+	switch (object.maxDist) {
+		case 0: break;
+		case 1: if (objDist > max_distance[0]) { return false; } break;
+		case 2: if (objDist > max_distance[1]) { return false; } break;
+		case 3: if (objDist > max_distance[2]) { return false; } break;
+		case 4: if (objDist > max_distance[3]) { return false; } break;
+	}
+
+	// light sources are uploaded separately and culled by their own range in UploadLights
+
+	// works best when mesh detail halves with each level of detail, textures pick their level per hit
+	object.SetMeshLoD(max(sqrt(camDist/camera.foclen)-1.0f, 0.0f));
+
+	// check if we should update object bounding box cache
+	if (!object.bCached) {
+		object.UpdateMatrices();
+		object.wvCached = false;
+		for (p=0; p<8; p++) {
+			object.bbvCache[p] = object.PointRelWorld(object.boundBox[p]);
+			object.bCached = true;
+		}
+	}
+
+	return true;
+}
+
+bool Game::ObjectOnScreen(Object& object)
+{
+	// get object position relative to cam
+	objPos = camera.PointRelCam(object.position);
+
+	// check if object is behind camera
+	if (objPos.z+object.radius <= 0.0f) { return false; }
+
+	maxX = maxY = 0.0f;
+	minX = minY = FLT_MAX;
+
+	// transform points on bounding box to screen coordinates
+	for (p=0; p<8; p++) {
+
+		// get corner of bounding box relative to cam
+		bboxVert = camera.PointRelCam(object.bbvCache[p]);
+
+		// map corner vertex onto screen coords
+		if (bboxVert.z < 0.0f) {
+			// fix coordinates for points behind cam
+			coords[p].x = (bboxVert.x < 0.0f) ? -1.0f : gfx.windowWidth;
+			coords[p].y = (bboxVert.y < 0.0f) ? -1.0f : gfx.windowHeight;
+		} else {
+			coords[p].x = widthHalf + (bboxVert.x / bboxVert.z) * camera.foclen;
+			coords[p].y = heightHalf + (bboxVert.y / bboxVert.z) * camera.foclen;
+		}
+
+		// get top left and bottom right coordinates
+		minX = min(coords[p].x, minX);
+		maxX = max(coords[p].x, maxX);
+		minY = min(coords[p].y, minY);
+		maxY = max(coords[p].y, maxY);
+	}
+
+	// cull objects not in field of view
+	if (((minX < 0.0f && maxX < 0.0f) || (minX > widthSpan && maxX > widthSpan))
+	|| ((minY < 0.0f && maxY < 0.0f) || (minY > widthSpan && maxY > widthSpan))) 
+	{ return false; }
+
+	// clip coordinates if outside screen
+	minX = min(max(minX, 0.0f), widthSpan);
+	minY = min(max(minY, 0.0f), heightSpan);
+	maxX = min(maxX, widthSpan);
+	maxY = min(maxY, heightSpan);
+
+	// calc rays needed for each axis of 2D BB
+	bbsX = maxX - minX + 1;
+	bbsY = maxY - minY + 1;
+
+	return true;
+}
+
+void Game::ComputeStage1(Object& object)
+{
+	// skip objects which can't be seen
+	if (!PrepareObject(object)) { return; }
+
+	// analytical spheres are saved for ComputeStage1S
+	if (object.type == -1) {
+
+		AABB bounds;
+		bounds.Grow(object.position - object.radius);
+		bounds.Grow(object.position + object.radius);
+		sphereInfo.push_back(object.info);
+		sphereBounds.push_back(bounds);
+
+	} else {
+
+		Mesh* pMesh = object.GetMesh();
+		Texture* pTex = object.GetTexture();
+
+		cl_MeshInfo meshInfo = pMesh->info;
+
+		// refresh world space vertices if needed
+		ComputeStage1V(object);
+
+		cl::Kernel& kernel = (persistGroups > 0) ? openCL.CTP_Kernel : openCL.CT_Kernel;
+
+		kernel.setArg(0, cl_rayBuff);
+		kernel.setArg(1, cl_ridBuff);
+		kernel.setArg(2, cl_cidBuff);
+		kernel.setArg(3, cl_mtrlSet);
+
+		kernel.setArg(4, *(pMesh->vertBuff));
+		kernel.setArg(5, cl_wvrtPool);
+		kernel.setArg(6, *(pMesh->triBuff));
+		kernel.setArg(7, *(pMesh->bvhBuff));
+		kernel.setArg(8, *(pMesh->idxBuff));
+		kernel.setArg(9, textSet.PoolMemory());
+
+		if (pTex->hasNormMap) {
+			kernel.setArg(10, *(pTex->normBuff));
+		} else {
+			kernel.setArg(10, NULL);
+		}
+
+		kernel.setArg(11, object.info);
+		kernel.setArg(12, meshInfo);
+		kernel.setArg(13, pTex->texInfo);
+		kernel.setArg(14, rInfo);
+		kernel.setArg(15, object.wvOffset);
+
+		if (persistGroups > 0) {
+			// a fixed set of work groups shares out the 2D bounding box
+			cl_uint4 pixBox = {(cl_uint)minX, (cl_uint)minY, (cl_uint)bbsX, (cl_uint)bbsY};
+			openCL.queue.enqueueWriteBuffer(cl_workCount, CL_FALSE, 0, sizeof(cl_uint), &workStart);
+			kernel.setArg(16, cl_workCount);
+			kernel.setArg(17, pixBox);
+			openCL.RunKernelP(kernel, persistGroups, PERSIST_SIZE);
+		} else {
+			// send rays through area covered by 2D bounding box
+			openCL.RunKernel1(minX, minY, bbsX, bbsY);
+		}
+	}
+}
+
+void Game::ComputeStage1V(Object& object)
+{
+	// the hierarchy path never reads world space vertices
+	if (mesh_bvh) { return; }
+
+	// only transform again after the object moves or changes LoD
+	if (object.wvCached && object.wvLod == object.meshLod) { return; }
+
+	Mesh* pMesh = object.GetMesh();
+
+	// every mode except object mode keeps meshes in the shared pools
+	if (render_mode != RENDER_OBJECTS) {
+		openCL.CV_Kernel.setArg(0, *(meshSet.vertPool));
+		openCL.CV_Kernel.setArg(3, pMesh->vOffset);
+	} else {
+		openCL.CV_Kernel.setArg(0, *(pMesh->vertBuff));
+		openCL.CV_Kernel.setArg(3, (cl_uint)0);
+	}
+
+	openCL.CV_Kernel.setArg(1, cl_wvrtPool);
+	openCL.CV_Kernel.setArg(2, object.info);
+	openCL.CV_Kernel.setArg(4, object.wvOffset);
+	openCL.CV_Kernel.setArg(5, pMesh->vCount);
+	openCL.CV_Kernel.setArg(6, pMesh->info);
+	openCL.RunKernelV(pMesh->vCount);
+
+	object.wvLod = object.meshLod;
+	object.wvCached = true;
+}
+
+void Game::ComputeStage1S()
+{
+	UINT32 sphereCount = sphereInfo.size();
+
+	if (sphereCount == 0) { return; }
+
+	// uploads read from the frame's own copies since they finish after this returns
+	FrameStage& stage = frameStages[openCL.frame_slot];
+	stage.sphereInfo.swap(sphereInfo);
+
+	// the hierarchy is rebuilt every frame since spheres move
+	stage.sphereBvh.Build(sphereBounds.data(), sphereCount);
+
+	openCL.queue.enqueueWriteBuffer(cl_sphBuff, CL_FALSE, 0, sizeof(cl_ObjectInfo)*sphereCount, stage.sphereInfo.data());
+	openCL.queue.enqueueWriteBuffer(cl_sbvhBuff, CL_FALSE, 0, sizeof(cl_BVHNode)*stage.sphereBvh.NodeCount(), stage.sphereBvh.nodes.data());
+	openCL.queue.enqueueWriteBuffer(cl_sidxBuff, CL_FALSE, 0, sizeof(cl_uint)*stage.sphereBvh.IndexCount(), stage.sphereBvh.indices.data());
+
+	openCL.CS_Kernel.setArg(0, cl_rayBuff);
+	openCL.CS_Kernel.setArg(1, cl_ridBuff);
+	openCL.CS_Kernel.setArg(2, cl_cidBuff);
+	openCL.CS_Kernel.setArg(3, cl_sphBuff);
+	openCL.CS_Kernel.setArg(4, cl_sbvhBuff);
+	openCL.CS_Kernel.setArg(5, cl_sidxBuff);
+	openCL.CS_Kernel.setArg(6, rInfo);
+
+	openCL.RunKernelS(gfx.windowWidth, gfx.windowHeight);
+
+	sphereInfo.clear();
+	sphereBounds.clear();
+}
+
+void Game::AddInstance(Object& object, UINT32 setIndex, bool onScreen)
+{
+	cl_Instance inst = {};
+	AABB bounds;
+
+	inst.object = object.info;
+	inst.occluder = object.isOccluder ? 1 : 0;
+
+	// stays the same while the object lives
+	inst.objectId = setIndex * MAX_OBJECTS + object.index;
+
+	// where the object was last frame, so reprojection follows rotation as well as movement
+	inst.lastToWorld = object.isStatic ? object.toWorld.matrix : 
+					   TransformMatrix(object.center, object.scale, object.lastOri, object.lastPos).matrix;
+
+	if (object.type == -1) {
+
+		// spheres are traced analytically so they carry no geometry
+		bounds.Grow(object.position - object.radius);
+		bounds.Grow(object.position + object.radius);
+
+	} else {
+
+		Mesh* pMesh = object.GetMesh();
+		Texture* pTex = object.GetTexture();
+
+		inst.mesh = pMesh->info;
+		inst.tex = pTex->texInfo;
+		inst.wvOffset = object.wvOffset;
+		inst.texAlpha = pTex->hasAlpha ? 1 : 0;
+
+		// refresh world space vertices if needed
+		ComputeStage1V(object);
+
+		// world space box around the cached bounding box corners
+		for (p=0; p<8; p++) {
+			bounds.Grow(object.bbvCache[p]);
+		}
+	}
+
+	// objects off screen can still block lights
+	if (!onScreen) {
+		outInstances.push_back(inst);
+		outBounds.push_back(bounds);
+		return;
+	}
+
+	instances.push_back(inst);
+	instBounds.push_back(bounds);
+
+	// screen area found by ObjectOnScreen, used for tile binning
+	cl_uint4 box = {(cl_uint)minX, (cl_uint)minY, (cl_uint)maxX, (cl_uint)maxY};
+	instBoxes.push_back(box);
+}
+
+UINT32 Game::UploadScene()
+{
+	UINT32 instCount = instances.size();
+	UINT32 worldCount = instCount + outInstances.size();
+
+	// nothing visible this frame
+	if (instCount == 0) {
+		outInstances.clear();
+		outBounds.clear();
+		return 0;
+	}
+
+	// objects off screen follow the visible ones so both hierarchies index the same buffer
+	instances.insert(instances.end(), outInstances.begin(), outInstances.end());
+	instBounds.insert(instBounds.end(), outBounds.begin(), outBounds.end());
+	outInstances.clear();
+	outBounds.clear();
+
+	// uploads read from the frame's own copies since they finish after this returns
+	FrameStage& stage = frameStages[openCL.frame_slot];
+	stage.instances.swap(instances);
+	stage.instBoxes.swap(instBoxes);
+
+	openCL.queue.enqueueWriteBuffer(cl_instBuff, CL_FALSE, 0, sizeof(cl_Instance)*worldCount, stage.instances.data());
+
+	// shadow and reflection rays also need the objects beside and behind the camera
+	if (lighting || refl_depth > 0) {
+		stage.worldTlas.Build(instBounds.data(), worldCount);
+		openCL.queue.enqueueWriteBuffer(cl_wlasBuff, CL_FALSE, 0, sizeof(cl_BVHNode)*stage.worldTlas.NodeCount(), stage.worldTlas.nodes.data());
+		openCL.queue.enqueueWriteBuffer(cl_widxBuff, CL_FALSE, 0, sizeof(cl_uint)*stage.worldTlas.IndexCount(), stage.worldTlas.indices.data());
+	}
+
+	// tiles replace the top level hierarchy in tiled mode
+	if (render_mode == RENDER_TILED) { return instCount; }
+
+	// the top level hierarchy is rebuilt every frame since objects move, primary rays only need the visible ones
+	stage.tlas.Build(instBounds.data(), instCount);
+
+	openCL.queue.enqueueWriteBuffer(cl_tlasBuff, CL_FALSE, 0, sizeof(cl_BVHNode)*stage.tlas.NodeCount(), stage.tlas.nodes.data());
+	openCL.queue.enqueueWriteBuffer(cl_tidxBuff, CL_FALSE, 0, sizeof(cl_uint)*stage.tlas.IndexCount(), stage.tlas.indices.data());
+
+	return instCount;
+}
+
+void Game::UploadLights()
+{
+	LightSet& lights = scene.lightSet;
+	cl_Light info = {};
+
+	lightInfo.clear();
+
+	// endless lights reach everything so only their direction matters
+	for (UINT32 i = 0; i < lights.el_count; i++) {
+		Light& light = lights.endless_lights[i];
+		info.direction = light.direction.vector;
+		info.color = light.color.vector;
+		info.power = light.power;
+		info.type = 0;
+		lightInfo.push_back(info);
+	}
+
+	clusterInfo.light_first = lightInfo.size();
+
+	for (UINT32 i = 0; i < lights.fl_count; i++) {
+		Light& light = lights.falloff_lights[i];
+		// skip lights too far away to reach anything near the camera
+		if (light.position.VectDist(camera.position) - light.range > max_light_dist) { continue; }
+		info.position = light.position.vector;
+		info.direction = light.direction.vector;
+		info.color = light.color.vector;
+		info.range = light.range;
+		info.power = light.power;
+		info.type = 1;
+		lightInfo.push_back(info);
+	}
+
+	clusterInfo.light_count = lightInfo.size();
+
+	// the upload reads the frame's own copy since it finishes after this returns
+	FrameStage& stage = frameStages[openCL.frame_slot];
+	stage.lightInfo.swap(lightInfo);
+
+	if (!stage.lightInfo.empty()) {
+		openCL.queue.enqueueWriteBuffer(cl_lightBuff, CL_FALSE, 0, sizeof(cl_Light)*stage.lightInfo.size(), stage.lightInfo.data());
+	}
+
+	// the last frame in this slot is done so its overflow counts are read without waiting
+	clusterFull = max(clusterFull, (UINT32)stage.clusterOverflow[0]);
+	clusterDrops = max(clusterDrops, (UINT32)stage.clusterOverflow[1]);
+
+	if (++lightFrames % FRAME_STATS_FRAMES == 0) {
+		if (clusterFull > 0) {
+			cout << "Light clusters over CLUSTER_LIGHTS ("+IntToStr(CLUSTER_LIGHTS)+"): "+IntToStr(clusterFull);
+			cout << ", lights dropped: "+IntToStr(clusterDrops)+" (worst frame)\n";
+		}
+		clusterFull = clusterDrops = 0;
+	}
+
+	// assign falloff lights to clusters for the current camera
+	openCL.queue.enqueueFillBuffer(cl_clusterOverflow, (cl_uint)0, 0, sizeof(cl_uint)*2);
+	openCL.LC_Kernel.setArg(0, cl_lightBuff);
+	openCL.LC_Kernel.setArg(1, cl_clusterLights);
+	openCL.LC_Kernel.setArg(2, cl_clusterCounts);
+	openCL.LC_Kernel.setArg(3, cl_clusterOverflow);
+	openCL.LC_Kernel.setArg(4, clusterInfo);
+	openCL.LC_Kernel.setArg(5, rInfo);
+	openCL.RunKernelQ(openCL.LC_Kernel, clusterCount, PERSIST_SIZE);
+	openCL.queue.enqueueReadBuffer(cl_clusterOverflow, CL_FALSE, 0, sizeof(cl_uint)*2, stage.clusterOverflow);
+}
+
+void Game::ComputeStage1W()
+{
+	if (UploadScene() == 0) { return; }
+
+	cl::Kernel& kernel = (persistGroups > 0) ? openCL.CWP_Kernel : openCL.CW_Kernel;
+
+	kernel.setArg(0, cl_rayBuff);
+	kernel.setArg(1, cl_ridBuff);
+	kernel.setArg(2, cl_cidBuff);
+	kernel.setArg(3, cl_mtrlSet);
+	kernel.setArg(4, *(meshSet.vertPool));
+	kernel.setArg(5, cl_wvrtPool);
+	kernel.setArg(6, *(meshSet.triPool));
+	kernel.setArg(7, *(meshSet.bvhPool));
+	kernel.setArg(8, *(meshSet.idxPool));
+	kernel.setArg(9, textSet.PoolMemory());
+	kernel.setArg(10, cl_instBuff);
+	kernel.setArg(11, cl_tlasBuff);
+	kernel.setArg(12, cl_tidxBuff);
+	kernel.setArg(13, rInfo);
+
+	// one dispatch covers every visible object
+	if (persistGroups > 0) {
+		openCL.queue.enqueueWriteBuffer(cl_workCount, CL_FALSE, 0, sizeof(cl_uint), &workStart);
+		kernel.setArg(14, cl_workCount);
+		kernel.setArg(15, pixCount);
+		openCL.RunKernelP(kernel, persistGroups, PERSIST_SIZE);
+	} else {
+		openCL.RunKernelW(gfx.windowWidth, gfx.windowHeight);
+	}
+
+	instances.clear();
+	instBounds.clear();
+	instBoxes.clear();
+}
+
+void Game::ScanQueue(cl::Buffer& dataIn, cl::Buffer& dataOut, UINT32 count, UINT32 level)
+{
+	UINT32 groups = (count + WAVE_SCAN_SIZE - 1) / WAVE_SCAN_SIZE;
+
+	// exclusive prefix sum inside each work group
+	openCL.SL_Kernel.setArg(0, dataIn);
+	openCL.SL_Kernel.setArg(1, dataOut);
+	openCL.SL_Kernel.setArg(2, cl_scanSums[level]);
+	openCL.SL_Kernel.setArg(3, count);
+	openCL.RunKernelQ(openCL.SL_Kernel, count, WAVE_SCAN_SIZE);
+
+	if (groups > 1) {
+		// scan the group totals then add them back to each group
+		ScanQueue(cl_scanSums[level], cl_scanSums[level], groups, level+1);
+		openCL.SA_Kernel.setArg(0, dataOut);
+		openCL.SA_Kernel.setArg(1, cl_scanSums[level]);
+		openCL.SA_Kernel.setArg(2, count);
+		openCL.RunKernelQ(openCL.SA_Kernel, count, WAVE_SCAN_SIZE);
+	}
+}
+
+void Game::CompactQueue(cl::Buffer& queueIn, cl::Buffer& queueOut, cl::Buffer& countOut, UINT32 cap)
+{
+	// queue entries flagged in cl_rayAlive keep their order, the whole capacity is scanned
+	// since only the device knows the queue length
+	ScanQueue(cl_rayAlive, cl_rayScan, cap, 0);
+
+	openCL.QC_Kernel.setArg(0, queueIn);
+	openCL.QC_Kernel.setArg(1, cl_rayAlive);
+	openCL.QC_Kernel.setArg(2, cl_rayScan);
+	openCL.QC_Kernel.setArg(3, queueOut);
+	openCL.QC_Kernel.setArg(4, countOut);
+	openCL.QC_Kernel.setArg(5, cap);
+	openCL.RunKernelQ(openCL.QC_Kernel, cap, WAVE_SCAN_SIZE);
+}
+
+void Game::ComputeStage1Q()
+{
+	if (UploadScene() == 0) { return; }
+
+	// every primary ray starts in the queue
+	openCL.queue.enqueueFillBuffer(cl_queueCount, (cl_uint)rInfo.ray_count, 0, sizeof(cl_uint));
+
+	TraceQueue();
+
+	instances.clear();
+	instBounds.clear();
+	instBoxes.clear();
+}
+
+void Game::TraceQueue()
+{
+	UINT32 q = 0;
+
+	openCL.CQ_Kernel.setArg(0, cl_rayBuff);
+	openCL.CQ_Kernel.setArg(1, cl_ridBuff);
+	openCL.CQ_Kernel.setArg(2, cl_cidBuff);
+	openCL.CQ_Kernel.setArg(3, cl_mtrlSet);
+	openCL.CQ_Kernel.setArg(4, *(meshSet.vertPool));
+	openCL.CQ_Kernel.setArg(5, cl_wvrtPool);
+	openCL.CQ_Kernel.setArg(6, *(meshSet.triPool));
+	openCL.CQ_Kernel.setArg(7, *(meshSet.bvhPool));
+	openCL.CQ_Kernel.setArg(8, *(meshSet.idxPool));
+	openCL.CQ_Kernel.setArg(9, textSet.PoolMemory());
+	openCL.CQ_Kernel.setArg(10, cl_instBuff);
+	openCL.CQ_Kernel.setArg(11, cl_tlasBuff);
+	openCL.CQ_Kernel.setArg(12, cl_tidxBuff);
+	openCL.CQ_Kernel.setArg(14, cl_rayAlive);
+	openCL.CQ_Kernel.setArg(15, cl_queueCount);
+	openCL.CQ_Kernel.setArg(16, rInfo.ray_count);
+	openCL.CQ_Kernel.setArg(18, rInfo);
+
+	// the queue length is set on the device by the caller, the queue holds every ray index
+	openCL.QI_Kernel.setArg(0, cl_rayQueue[q]);
+	openCL.QI_Kernel.setArg(1, rInfo.ray_count);
+	openCL.RunKernelQ(openCL.QI_Kernel, rInfo.ray_count, WAVE_SCAN_SIZE);
+
+	// find one transparency layer per pass for the rays still in the queue,
+	// rays past the queue length return straight away
+	for (UINT32 layer = 0; layer < trans_depth; layer++) {
+
+		openCL.CQ_Kernel.setArg(13, cl_rayQueue[q]);
+		openCL.CQ_Kernel.setArg(17, layer);
+		openCL.RunKernelQ(openCL.CQ_Kernel, rInfo.ray_count, WAVE_SCAN_SIZE);
+
+		if (layer+1 == trans_depth) { break; }
+
+		// compact the surviving rays into the other queue
+		CompactQueue(cl_rayQueue[q], cl_rayQueue[1-q], cl_queueCount, rInfo.ray_count);
+		q = 1 - q;
+	}
+}
+
+void Game::ComputeStage1B()
+{
+	UINT32 instCount = UploadScene();
+
+	if (instCount == 0) { return; }
+
+	openCL.queue.enqueueWriteBuffer(cl_instBoxes, CL_FALSE, 0, sizeof(cl_uint4)*instCount, frameStages[openCL.frame_slot].instBoxes.data());
+
+	// reset tile counters
+	openCL.BC_Kernel.setArg(0, cl_tileCounts);
+	openCL.BC_Kernel.setArg(1, tileCount);
+	openCL.RunKernelQ(openCL.BC_Kernel, tileCount, WAVE_SCAN_SIZE);
+	openCL.BC_Kernel.setArg(0, cl_tileFill);
+	openCL.RunKernelQ(openCL.BC_Kernel, tileCount, WAVE_SCAN_SIZE);
+
+	// count objects overlapping each tile
+	openCL.TC_Kernel.setArg(0, cl_instBoxes);
+	openCL.TC_Kernel.setArg(1, cl_tileCounts);
+	openCL.TC_Kernel.setArg(2, instCount);
+	openCL.TC_Kernel.setArg(3, tileSize);
+	openCL.TC_Kernel.setArg(4, tilesX);
+	openCL.RunKernelQ(openCL.TC_Kernel, instCount, PERSIST_SIZE);
+
+	// turn the counts into list offsets
+	ScanQueue(cl_tileCounts, cl_tileOffsets, tileCount, 0);
+
+	// write object indexes into the tile lists
+	openCL.TF_Kernel.setArg(0, cl_instBoxes);
+	openCL.TF_Kernel.setArg(1, cl_tileOffsets);
+	openCL.TF_Kernel.setArg(2, cl_tileFill);
+	openCL.TF_Kernel.setArg(3, cl_tileRefs);
+	openCL.TF_Kernel.setArg(4, instCount);
+	openCL.TF_Kernel.setArg(5, tileSize);
+	openCL.TF_Kernel.setArg(6, tilesX);
+	openCL.RunKernelQ(openCL.TF_Kernel, instCount, PERSIST_SIZE);
+
+	openCL.CB_Kernel.setArg(0, cl_rayBuff);
+	openCL.CB_Kernel.setArg(1, cl_ridBuff);
+	openCL.CB_Kernel.setArg(2, cl_cidBuff);
+	openCL.CB_Kernel.setArg(3, cl_mtrlSet);
+	openCL.CB_Kernel.setArg(4, *(meshSet.vertPool));
+	openCL.CB_Kernel.setArg(5, cl_wvrtPool);
+	openCL.CB_Kernel.setArg(6, *(meshSet.triPool));
+	openCL.CB_Kernel.setArg(7, *(meshSet.bvhPool));
+	openCL.CB_Kernel.setArg(8, *(meshSet.idxPool));
+	openCL.CB_Kernel.setArg(9, textSet.PoolMemory());
+	openCL.CB_Kernel.setArg(10, cl_instBuff);
+	openCL.CB_Kernel.setArg(11, cl_tileCounts);
+	openCL.CB_Kernel.setArg(12, cl_tileOffsets);
+	openCL.CB_Kernel.setArg(13, cl_tileRefs);
+	openCL.CB_Kernel.setArg(14, tileSize);
+	openCL.CB_Kernel.setArg(15, tilesX);
+	openCL.CB_Kernel.setArg(16, rInfo);
+
+	// every tile traced in one dispatch
+	openCL.RunKernelB(gfx.windowWidth, gfx.windowHeight);
+
+	if (++frameCount % TILE_STATS_FRAMES == 0) { PrintTileStats(instCount); }
+
+	instances.clear();
+	instBounds.clear();
+	instBoxes.clear();
+}
+
+void Game::PrintTileStats(UINT32 instCount)
+{
+	vector<cl_uint> counts(tileCount);
+	UINT32 used = 0, refs = 0, most = 0;
+
+	openCL.queue.enqueueReadBuffer(cl_tileCounts, CL_TRUE, 0, sizeof(cl_uint)*tileCount, counts.data());
+
+	for (UINT32 ti = 0; ti < tileCount; ti++) {
+		if (counts[ti] > 0) { used++; }
+		refs += counts[ti];
+		most = max(most, (UINT32)counts[ti]);
+	}
+
+	cout << "Tiles: "+IntToStr(tilesX)+"x"+IntToStr(tilesY)+" of "+IntToStr(tileSize)+"px, ";
+	cout << "objects: "+IntToStr(instCount)+", used tiles: "+IntToStr(used)+", ";
+	cout << "refs: "+IntToStr(refs)+", avg per used tile: "+DblToStr(used ? (double)refs/used : 0.0)+", ";
+	cout << "max per tile: "+IntToStr(most)+"\n";
+}
+
+void Game::ComputeStage1L()
+{
+	// shade every visible layer using shadow rays towards each light
+	openCL.LT_Kernel.setArg(0, cl_rayBuff);
+	openCL.LT_Kernel.setArg(1, cl_ridBuff);
+	openCL.LT_Kernel.setArg(2, cl_cidBuff);
+	openCL.LT_Kernel.setArg(3, *(meshSet.vertPool));
+	openCL.LT_Kernel.setArg(4, cl_wvrtPool);
+	openCL.LT_Kernel.setArg(5, *(meshSet.triPool));
+	openCL.LT_Kernel.setArg(6, *(meshSet.bvhPool));
+	openCL.LT_Kernel.setArg(7, *(meshSet.idxPool));
+	openCL.LT_Kernel.setArg(8, cl_instBuff);
+	openCL.LT_Kernel.setArg(9, cl_wlasBuff);
+	openCL.LT_Kernel.setArg(10, cl_widxBuff);
+	openCL.LT_Kernel.setArg(11, cl_lightBuff);
+	openCL.LT_Kernel.setArg(12, cl_clusterLights);
+	openCL.LT_Kernel.setArg(13, cl_clusterCounts);
+	openCL.LT_Kernel.setArg(14, clusterInfo);
+	openCL.LT_Kernel.setArg(15, scene.lightSet.ambLight.vector);
+	openCL.LT_Kernel.setArg(16, max_shadow_dist);
+	openCL.LT_Kernel.setArg(17, rInfo);
+	openCL.RunKernelQ(openCL.LT_Kernel, rInfo.ray_count, PERSIST_SIZE);
+}
+
+void Game::ComputeResolve()
+{
+	// fetch surface colors once for the hits left in the visibility planes
+	openCL.RS_Kernel.setArg(0, cl_rayBuff);
+	openCL.RS_Kernel.setArg(1, cl_ridBuff);
+	openCL.RS_Kernel.setArg(2, cl_cidBuff);
+	openCL.RS_Kernel.setArg(3, cl_mtrlSet);
+	openCL.RS_Kernel.setArg(4, *(meshSet.vertPool));
+	openCL.RS_Kernel.setArg(5, cl_wvrtPool);
+	openCL.RS_Kernel.setArg(6, *(meshSet.triPool));
+	openCL.RS_Kernel.setArg(7, *(meshSet.bvhPool));
+	openCL.RS_Kernel.setArg(8, *(meshSet.idxPool));
+	openCL.RS_Kernel.setArg(9, textSet.PoolMemory());
+	openCL.RS_Kernel.setArg(10, cl_instBuff);
+	openCL.RS_Kernel.setArg(11, cl_wlasBuff);
+	openCL.RS_Kernel.setArg(12, cl_widxBuff);
+	openCL.RS_Kernel.setArg(13, cl_lightBuff);
+	openCL.RS_Kernel.setArg(14, cl_clusterLights);
+	openCL.RS_Kernel.setArg(15, cl_clusterCounts);
+	openCL.RS_Kernel.setArg(16, clusterInfo);
+	openCL.RS_Kernel.setArg(17, scene.lightSet.ambLight.vector);
+	openCL.RS_Kernel.setArg(18, max_shadow_dist);
+	openCL.RS_Kernel.setArg(19, rInfo);
+	openCL.RunKernelQ(openCL.RS_Kernel, rInfo.ray_count, PERSIST_SIZE);
+}
+
+void Game::ComputeStage1R()
+{
+	UINT32 q = 0;
+
+	// the queue starts with every ray so the flags line up with the ray indexes
+	openCL.QI_Kernel.setArg(0, cl_rayQueue[q]);
+	openCL.QI_Kernel.setArg(1, rInfo.ray_count);
+	openCL.RunKernelQ(openCL.QI_Kernel, rInfo.ray_count, WAVE_SCAN_SIZE);
+
+	// flag the rays whose nearest layer reflects and start their reflection rays
+	openCL.RI_Kernel.setArg(0, cl_rayBuff);
+	openCL.RI_Kernel.setArg(1, cl_ridBuff);
+	openCL.RI_Kernel.setArg(2, cl_cidBuff);
+	openCL.RI_Kernel.setArg(3, cl_mtrlSet);
+	openCL.RI_Kernel.setArg(4, *(meshSet.vertPool));
+	openCL.RI_Kernel.setArg(5, *(meshSet.triPool));
+	openCL.RI_Kernel.setArg(6, cl_instBuff);
+	openCL.RI_Kernel.setArg(7, cl_secRays);
+	openCL.RI_Kernel.setArg(8, cl_rayAlive);
+	openCL.RI_Kernel.setArg(9, rInfo);
+	openCL.RunKernelQ(openCL.RI_Kernel, rInfo.ray_count, PERSIST_SIZE);
+
+	// only reflective hits are traced from here on
+	CompactQueue(cl_rayQueue[q], cl_rayQueue[1-q], cl_queueCount, rInfo.ray_count);
+	q = 1 - q;
+
+	openCL.RF_Kernel.setArg(1, cl_rayAlive);
+	openCL.RF_Kernel.setArg(2, cl_secRays);
+	openCL.RF_Kernel.setArg(3, cl_cidBuff);
+	openCL.RF_Kernel.setArg(4, cl_mtrlSet);
+	openCL.RF_Kernel.setArg(5, *(meshSet.vertPool));
+	openCL.RF_Kernel.setArg(6, cl_wvrtPool);
+	openCL.RF_Kernel.setArg(7, *(meshSet.triPool));
+	openCL.RF_Kernel.setArg(8, *(meshSet.bvhPool));
+	openCL.RF_Kernel.setArg(9, *(meshSet.idxPool));
+	openCL.RF_Kernel.setArg(10, textSet.PoolMemory());
+	openCL.RF_Kernel.setArg(11, cl_instBuff);
+	openCL.RF_Kernel.setArg(12, cl_wlasBuff);
+	openCL.RF_Kernel.setArg(13, cl_widxBuff);
+	openCL.RF_Kernel.setArg(14, cl_lightBuff);
+	openCL.RF_Kernel.setArg(15, clusterInfo);
+	openCL.RF_Kernel.setArg(16, scene.lightSet.ambLight.vector);
+	openCL.RF_Kernel.setArg(17, max_shadow_dist);
+	openCL.RF_Kernel.setArg(18, max_distance[3]);
+	openCL.RF_Kernel.setArg(19, cl_queueCount);
+	openCL.RF_Kernel.setArg(20, rInfo.ray_count);
+
+	// each bounce only traces the rays which hit another reflective surface
+	for (UINT32 bounce = 0; bounce < refl_depth; bounce++) {
+
+		openCL.RF_Kernel.setArg(0, cl_rayQueue[q]);
+		openCL.RF_Kernel.setArg(21, (cl_uint)(bounce+1 == refl_depth));
+		openCL.RunKernelQ(openCL.RF_Kernel, rInfo.ray_count, WAVE_SCAN_SIZE);
+
+		if (bounce+1 == refl_depth) { break; }
+
+		CompactQueue(cl_rayQueue[q], cl_rayQueue[1-q], cl_queueCount, rInfo.ray_count);
+		q = 1 - q;
+	}
+}
+
+void Game::ComputeStage2()
+{
+	// compute final pixel colors
+	openCL.CL_Kernel.setArg(0, cl_rayBuff);
+	openCL.CL_Kernel.setArg(1, cl_cidBuff);
+	openCL.CL_Kernel.setArg(2, gfx.gl_backBuff);
+	openCL.CL_Kernel.setArg(3, rInfo);
+	openCL.RunKernel2(gfx.windowWidth, gfx.windowHeight);
+}
+
+void Game::ComputeStage2T()
+{
+	// blend with what the previous frame saw at the same surface points
+	openCL.TA_Kernel.setArg(0, cl_rayBuff);
+	openCL.TA_Kernel.setArg(1, cl_ridBuff);
+	openCL.TA_Kernel.setArg(2, cl_cidBuff);
+	openCL.TA_Kernel.setArg(3, gfx.gl_backBuff);
+	openCL.TA_Kernel.setArg(4, cl_instBuff);
+	openCL.TA_Kernel.setArg(5, cl_histColor[histIndex]);
+	openCL.TA_Kernel.setArg(6, cl_histId[histIndex]);
+	openCL.TA_Kernel.setArg(7, cl_histColor[1-histIndex]);
+	openCL.TA_Kernel.setArg(8, cl_histId[1-histIndex]);
+	openCL.TA_Kernel.setArg(9, prevInfo);
+	openCL.TA_Kernel.setArg(10, rInfo);
+	openCL.RunKernelT(gfx.windowWidth, gfx.windowHeight);
+
+	// this frame becomes the history of the next one
+	histIndex = 1 - histIndex;
+	prevInfo = rInfo;
+}
+
+void Game::ComputeStage2A()
+{
+	UINT32 q = 0;
+
+	// flag pixels which differ from a neighbour in the first pass
+	openCL.ED_Kernel.setArg(0, cl_rayBuff);
+	openCL.ED_Kernel.setArg(1, cl_ridBuff);
+	openCL.ED_Kernel.setArg(2, cl_cidBuff);
+	openCL.ED_Kernel.setArg(3, cl_rayAlive);
+	openCL.ED_Kernel.setArg(4, rInfo);
+	openCL.RunKernelE(gfx.windowWidth, gfx.windowHeight);
+
+	// gather the flagged pixels, the buffers only fit refineCap of them so the rest keep one ray
+	openCL.QI_Kernel.setArg(0, cl_rayQueue[q]);
+	openCL.QI_Kernel.setArg(1, pixCount);
+	openCL.RunKernelQ(openCL.QI_Kernel, pixCount, WAVE_SCAN_SIZE);
+	CompactQueue(cl_rayQueue[q], cl_refineList, cl_refineCount, pixCount);
+
+	// second pass traces every sub-ray of the refined pixels, the pass is sized for a full
+	// list and the sub-ray kernel sets the queue length from the real one
+	rInfo.ray_count = refineCap * aaInfo.lvl;
+	openCL.RA_Kernel.setArg(0, cl_rayBuff);
+	openCL.RA_Kernel.setArg(1, cl_refineList);
+	openCL.RA_Kernel.setArg(2, cl_refineCount);
+	openCL.RA_Kernel.setArg(3, cl_queueCount);
+	openCL.RA_Kernel.setArg(4, refineCap);
+	openCL.RA_Kernel.setArg(5, rInfo);
+	openCL.RunKernelQ(openCL.RA_Kernel, rInfo.ray_count, WAVE_SCAN_SIZE);
+
+	TraceQueue();
+	ShadeLayers();
+
+	// overwrite the refined pixels with the average of their sub-rays
+	openCL.LA_Kernel.setArg(0, cl_rayBuff);
+	openCL.LA_Kernel.setArg(1, cl_cidBuff);
+	openCL.LA_Kernel.setArg(2, gfx.gl_backBuff);
+	openCL.LA_Kernel.setArg(3, cl_refineList);
+	openCL.LA_Kernel.setArg(4, cl_refineCount);
+	openCL.LA_Kernel.setArg(5, refineCap);
+	openCL.LA_Kernel.setArg(6, rInfo);
+	openCL.RunKernelQ(openCL.LA_Kernel, refineCap, WAVE_SCAN_SIZE);
+}
+
+void Game::ShadeLayers()
+{
+	// deferred surface evaluation also shades the surface
+	if (vis_buffer) { 
+		ComputeResolve(); 
+	} else if (lighting) { 
+		ComputeStage1L(); 
+	}
+
+	// reflective surfaces blend in what their reflection rays hit
+	if (refl_depth > 0) { ComputeStage1R(); }
+}
+
+void Game::RenderScene()
+{
+	// loop through all object sets
+	for (s = 0; s < scene.objectSets.count; s++) 
+	{
+		// get reference to current object set
+		ObjectSet& objSet = *(scene.objectSets.GetSetByIndex(s));
+		
+		// loop through all objects in this set
+		for (o = 0; o < objSet.count; o++) 
+		{
+			Object& object = *(objSet.ObjectByIndex(o));
+
+			if (render_mode != RENDER_OBJECTS) {
+				// gather objects in range for the scene kernels, only those on screen get primary rays
+				if (ObjectInRange(object)) { AddInstance(object, s, ObjectOnScreen(object)); }
+			} else {
+				// do primary ray computations
+				ComputeStage1(object);
+			}
+		}
+	}
+
+	// trace all gathered objects at once
+	if (render_mode == RENDER_OBJECTS) {
+		ComputeStage1S();
+	} else if (render_mode == RENDER_SCENE) { 
+		ComputeStage1W(); 
+	} else if (render_mode == RENDER_WAVEFRONT) { 
+		ComputeStage1Q(); 
+	} else if (render_mode == RENDER_TILED) { 
+		ComputeStage1B(); 
+	}
+
+	// lights may move every frame
+	if (lighting) { UploadLights(); }
+
+	ShadeLayers();
+
+	// lighting computations
+	if (temporal_aa) {
+		ComputeStage2T();
+	} else {
+		ComputeStage2();
+	}
+
+	// second pass over the pixels on edges
+	if (aa_refine > 0) { ComputeStage2A(); }
+}
+
+void Game::ComposeFrame()
+{
+	// TODO: refactor code for pixel-blocks
+
+	// reuse the buffers of the oldest frame once the device is done with it
+	openCL.BeginFrame();
+	gfx.SelectBackBuff(openCL.frame_slot);
+
+	// handle keyboard/mouse actions
+	HandleInput();
+
+	// reset/update some stuff
+	BeginActions();
+
+	// give OCL control of OGL framebuffer
+	gfx.AcquireBackBuff(openCL.queue());
+
+	// render the 3D scene using OCL
+	RenderScene();
+
+	// make OCL release control of OGL memory
+	gfx.ReleaseBackBuff(openCL.queue());
+
+	// the host moves on to the next frame while the device works on this one
+	openCL.EndFrame();
 }
\ No newline at end of file
@@ -1,71 +1,175 @@
-#pragma once
-#include "GLGraphics.h"
-#include "Resource.h"
-#include "CLTypes.h"
-#include "Keyboard.h"
-#include "Mouse.h"
-#include "Timer.h"
-#include "FrameTimer.h"
-#include "Materials.h"
-#include "Objects.h"
-#include "Scene.h"
-
-class Game
-{
-public:
-	Game(GLFWwindow* window, KeyboardServer& kServer, MouseServer& mServer);
-	~Game();
-	void Go();
-	void ComputeStage1(Object& object);
-	void ComputeStage2();
-	void ComputeStage3();
-private:
-	void RenderScene();
-	void HandleInput();
-	void BeginActions();
-	void ComposeFrame();
-private:
-	KeyboardClient kbd;
-	MouseClient mouse;
-	GLGraphics gfx;
-
-	CL openCL;
-	cl_int cl_error;
-	cl_RenderInfo rInfo;
-
-	cl::Buffer cl_rayBuff;
-	cl::Buffer cl_pixBuff;
-	cl::Buffer cl_ridBuff;
-	cl::Buffer cl_cidBuff;
-	cl::Buffer cl_mtrlSet;
-
-	Scene scene;
-	Camera camera;
-	Font* DefFont;
-
-	cl_float3* rayBuff;
-	cl_AAInfo aaInfo;
-	Vec3 bboxVert;
-	Vec3 blpRay;
-	Vec3 objPos;
-	Vec2 coords[8];
-
-	size_t bbsX, bbsY;
-	UINT32 n,o,s,x,p;
-	UINT32 pixCount, rayCount;
-	UINT32 heightSpan, widthSpan;
-	UINT32 heightRays, widthRays;
-	UINT32 heightHalf, widthHalf;
-	float maxX, minX, maxY, minY;
-	float objDist, dX, dY;
-	float max_distance[4];
-	unsigned char trans_depth;
-	unsigned char sub_rays;
-
-	MaterialSet matSet;
-	MeshSet meshSet;
-	TextureSet textSet;
-
-	float deltaTime;
-	Timer deltaTimer;
+#pragma once
+#include "GLGraphics.h"
+#include "Resource.h"
+#include "CLTypes.h"
+#include "Keyboard.h"
+#include "Mouse.h"
+#include "Timer.h"
+#include "FrameTimer.h"
+#include "Materials.h"
+#include "Objects.h"
+#include "Scene.h"
+
+// host copies of what a frame uploads without blocking, kept until that frame is done
+struct FrameStage
+{
+	vector<cl_Instance> instances;
+	vector<cl_uint4> instBoxes;
+	vector<cl_Light> lightInfo;
+	vector<cl_ObjectInfo> sphereInfo;
+	cl_uint clusterOverflow[2] = {};
+	BVH tlas;
+	BVH worldTlas;
+	BVH sphereBvh;
+};
+
+class Game
+{
+public:
+	Game(GLFWwindow* window, KeyboardServer& kServer, MouseServer& mServer);
+	~Game();
+	void Go();
+	void ComputeStage1(Object& object);
+	void ComputeStage1V(Object& object);
+	void ComputeStage1S();
+	void ComputeStage1W();
+	void ComputeStage1Q();
+	void ComputeStage1B();
+	void ComputeStage1L();
+	void ComputeResolve();
+	void ComputeStage1R();
+	void ComputeStage2();
+	void ComputeStage2A();
+	void ComputeStage2T();
+	void ComputeStage3();
+private:
+	void RenderScene();
+	void HandleInput();
+	void BeginActions();
+	void ComposeFrame();
+	bool PrepareObject(Object& object);
+	bool ObjectInRange(Object& object);
+	bool ObjectOnScreen(Object& object);
+	void AddInstance(Object& object, UINT32 setIndex, bool onScreen);
+	UINT32 UploadScene();
+	void UploadLights();
+	void TraceQueue();
+	void ShadeLayers();
+	void PrintTileStats(UINT32 instCount);
+	void ScanQueue(cl::Buffer& dataIn, cl::Buffer& dataOut, UINT32 count, UINT32 level);
+	void CompactQueue(cl::Buffer& queueIn, cl::Buffer& queueOut, cl::Buffer& countOut, UINT32 cap);
+private:
+	KeyboardClient kbd;
+	MouseClient mouse;
+	GLGraphics gfx;
+
+	CL openCL;
+	cl_int cl_error;
+	cl_RenderInfo rInfo;
+	cl_RenderInfo prevInfo;
+
+	cl::Buffer cl_rayBuff;
+	cl::Buffer cl_pixBuff;
+	cl::Buffer cl_ridBuff;
+	cl::Buffer cl_cidBuff;
+	cl::Buffer cl_mtrlSet;
+	cl::Buffer cl_instBuff;
+	cl::Buffer cl_tlasBuff;
+	cl::Buffer cl_tidxBuff;
+	cl::Buffer cl_wlasBuff;
+	cl::Buffer cl_widxBuff;
+	cl::Buffer cl_sphBuff;
+	cl::Buffer cl_sbvhBuff;
+	cl::Buffer cl_sidxBuff;
+	cl::Buffer cl_wvrtPool;
+	cl::Buffer cl_workCount;
+	cl::Buffer cl_instBoxes;
+	cl::Buffer cl_tileCounts;
+	cl::Buffer cl_tileOffsets;
+	cl::Buffer cl_tileFill;
+	cl::Buffer cl_tileRefs;
+	cl::Buffer cl_rayQueue[2];
+	cl::Buffer cl_rayAlive;
+	cl::Buffer cl_rayScan;
+	cl::Buffer cl_queueCount;
+	cl::Buffer cl_lightBuff;
+	cl::Buffer cl_clusterLights;
+	cl::Buffer cl_clusterCounts;
+	cl::Buffer cl_clusterOverflow;
+	cl::Buffer cl_secRays;
+	cl::Buffer cl_refineList;
+	cl::Buffer cl_refineCount;
+	cl::Buffer cl_histColor[2];
+	cl::Buffer cl_histId[2];
+	vector<cl::Buffer> cl_scanSums;
+
+	Scene scene;
+	Camera camera;
+	Font* DefFont;
+
+	cl_float3* rayBuff;
+	cl_AAInfo aaInfo;
+	Vec3 bboxVert;
+	Vec3 blpRay;
+	Vec3 objPos;
+	Vec2 coords[8];
+
+	size_t bbsX, bbsY;
+	UINT32 n,o,s,x,p;
+	UINT32 pixCount, rayCount;
+	UINT32 refineCap;
+	UINT32 heightSpan, widthSpan;
+	UINT32 heightRays, widthRays;
+	UINT32 heightHalf, widthHalf;
+	float maxX, minX, maxY, minY;
+	float objDist, dX, dY;
+	float max_distance[4];
+	unsigned char trans_depth;
+	unsigned char sub_rays;
+	unsigned char render_mode;
+	bool mesh_bvh;
+	bool tri_tiling;
+	bool vis_buffer;
+	bool lighting;
+	UINT32 refl_depth;
+	bool mesh_quant;
+	bool short_index;
+	bool tex_compress;
+	bool tex_compare;
+	bool show_bf;
+	UINT32 aa_refine;
+	bool temporal_aa;
+	UINT32 histIndex, jitterIndex;
+	bool fast_math;
+	float max_light_dist;
+	float max_shadow_dist;
+
+	vector<cl_Instance> instances;
+	vector<AABB> instBounds;
+	vector<cl_Instance> outInstances;
+	vector<AABB> outBounds;
+	vector<cl_ObjectInfo> sphereInfo;
+	vector<AABB> sphereBounds;
+	vector<cl_uint4> instBoxes;
+	vector<cl_Light> lightInfo;
+	cl_ClusterInfo clusterInfo;
+	UINT32 clusterCount;
+	UINT32 clusterFull, clusterDrops;
+	UINT32 lightFrames;
+	UINT32 maxInstances;
+	UINT32 persistGroups;
+	cl_uint workStart;
+	UINT32 tileSize, tilesX, tilesY, tileCount;
+	UINT32 frameCount;
+	UINT32 statsCount;
+	FrameTimer frameTimer;
+	vector<FrameStage> frameStages;
+	UINT32 frames_in_flight;
+
+	MaterialSet matSet;
+	MeshSet meshSet;
+	TextureSet textSet;
+
+	float deltaTime;
+	Timer deltaTimer;
 };
\ No newline at end of file
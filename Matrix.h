@@ -0,0 +1,77 @@
+#pragma once
+#include "MathExt.h"
+#include "Vec3.h"
+#include "CLTypes.h"
+
+class Mat3x4 {
+public:
+	union {
+		cl_Matrix3x4 matrix;
+		float m[3][4];
+	};
+	inline Mat3x4()
+	{
+		setCols(V3_X1, V3_Y1, V3_Z1, Vec3(0, 0, 0));
+	}
+	inline void setCols(const Vec3& c0, const Vec3& c1, const Vec3& c2, const Vec3& t)
+	{
+		m[0][0] = c0.x; m[0][1] = c1.x; m[0][2] = c2.x; m[0][3] = t.x;
+		m[1][0] = c0.y; m[1][1] = c1.y; m[1][2] = c2.y; m[1][3] = t.y;
+		m[2][0] = c0.z; m[2][1] = c1.z; m[2][2] = c2.z; m[2][3] = t.z;
+	}
+	inline void setRows(const Vec3& r0, const Vec3& r1, const Vec3& r2, const Vec3& t)
+	{
+		m[0][0] = r0.x; m[0][1] = r0.y; m[0][2] = r0.z; m[0][3] = t.x;
+		m[1][0] = r1.x; m[1][1] = r1.y; m[1][2] = r1.z; m[1][3] = t.y;
+		m[2][0] = r2.x; m[2][1] = r2.y; m[2][2] = r2.z; m[2][3] = t.z;
+	}
+	inline Vec3 Point(const Vec3& p) const
+	{
+		return Vec3(m[0][0]*p.x + m[0][1]*p.y + m[0][2]*p.z + m[0][3],
+					m[1][0]*p.x + m[1][1]*p.y + m[1][2]*p.z + m[1][3],
+					m[2][0]*p.x + m[2][1]*p.y + m[2][2]*p.z + m[2][3]);
+	}
+	inline Vec3 Dir(const Vec3& d) const
+	{
+		return Vec3(m[0][0]*d.x + m[0][1]*d.y + m[0][2]*d.z,
+					m[1][0]*d.x + m[1][1]*d.y + m[1][2]*d.z,
+					m[2][0]*d.x + m[2][1]*d.y + m[2][2]*d.z);
+	}
+	inline Mat3x4 Inverse() const
+	{
+		Mat3x4 inv;
+		float det = m[0][0] * (m[1][1]*m[2][2] - m[1][2]*m[2][1])
+				  - m[0][1] * (m[1][0]*m[2][2] - m[1][2]*m[2][0])
+				  + m[0][2] * (m[1][0]*m[2][1] - m[1][1]*m[2][0]);
+		float id = (det != 0.0f) ? 1.0f / det : 0.0f;
+
+		inv.m[0][0] = (m[1][1]*m[2][2] - m[1][2]*m[2][1]) * id;
+		inv.m[0][1] = (m[0][2]*m[2][1] - m[0][1]*m[2][2]) * id;
+		inv.m[0][2] = (m[0][1]*m[1][2] - m[0][2]*m[1][1]) * id;
+		inv.m[1][0] = (m[1][2]*m[2][0] - m[1][0]*m[2][2]) * id;
+		inv.m[1][1] = (m[0][0]*m[2][2] - m[0][2]*m[2][0]) * id;
+		inv.m[1][2] = (m[0][2]*m[1][0] - m[0][0]*m[1][2]) * id;
+		inv.m[2][0] = (m[1][0]*m[2][1] - m[1][1]*m[2][0]) * id;
+		inv.m[2][1] = (m[0][1]*m[2][0] - m[0][0]*m[2][1]) * id;
+		inv.m[2][2] = (m[0][0]*m[1][1] - m[0][1]*m[1][0]) * id;
+
+		// undo the translation after the linear part
+		Vec3 t = inv.Dir(Vec3(m[0][3], m[1][3], m[2][3]));
+		inv.m[0][3] = -t.x;
+		inv.m[1][3] = -t.y;
+		inv.m[2][3] = -t.z;
+		return inv;
+	}
+};
+
+// matrix for VectRot(rot) applied to (p - center) * scale, then moved to position
+inline Mat3x4 TransformMatrix(const Vec3& center, const float scale, const Vec3& rot, const Vec3& pos)
+{
+	Mat3x4 result;
+	Vec3 c0 = V3_X1.VectRot(rot) * scale;
+	Vec3 c1 = V3_Y1.VectRot(rot) * scale;
+	Vec3 c2 = V3_Z1.VectRot(rot) * scale;
+	result.setCols(c0, c1, c2, Vec3(0, 0, 0));
+	result.setCols(c0, c1, c2, pos.VectSub(result.Dir(center)));
+	return result;
+}
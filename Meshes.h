@@ -1,277 +1,515 @@
-#pragma once
-#include "MathExt.h"
-#include "Vec3.h"
-#include "Materials.h"
-#include "Triangles.h"
-#include "ReadWrite.h"
-#include "CLTypes.h"
-#include <string>
-#include <fstream>
-#include <assert.h>
-
-using namespace std;
-
-class Mesh
-{
-public:
-	cl::Buffer* vertBuff;
-	cl::Buffer* normBuff;
-	cl::Buffer* triBuff;
-	Vec3 boundBox[8];
-	Vec3* vertices;
-	Vec3* normals;
-	Triangle* triangles;
-	string id;
-	UINT32 index;
-	union {
-		cl_MeshInfo info;
-		struct {
-			UINT32 tCount;
-			UINT32 vCount;
-			UINT32 nCount;
-			float radius;
-			Vec3 center;
-		};
-	};
-public:
-	void InitMesh()
-	{
-		vertBuff = nullptr;
-		normBuff = nullptr;
-		triBuff = nullptr;
-		vertices = nullptr;
-		normals = nullptr;
-		triangles = nullptr;
-		vCount = 0;
-		tCount = 0;
-		radius = 0;
-		center = Vec3(0, 0, 0);
-		id = "";
-	}
-	void FreeMesh()
-	{
-		if (vertices != nullptr)
-		{
-			delete[] vertices;
-		}
-		if (normals != nullptr)
-		{
-			delete[] normals;
-		}
-		if (triangles != nullptr)
-		{
-			delete[] triangles;
-		}
-		vertices = nullptr;
-		normals = nullptr;
-		triangles = nullptr;
-	}
-	Mesh()
-	{
-		InitMesh();
-	}
-	Mesh(const string filename)
-	{
-		InitMesh();
-		Load(filename);
-	}
-	void LoadMesh(const string filename)
-	{
-		FreeMesh();
-		InitMesh();
-		Load(filename);
-	}
-	void Load(const string filename)
-	{
-		ifstream myfile(filename);
-		string line, key, data;
-		size_t bpos;
-		Vec3 tempVec;
-		UINT32 format, version;
-		UINT32 i, index = 0;
-		UINT32 vi1,vi2,vi3;
-		char tChar = '\n';
-		radius = 0;
-
-		try {
-			if (myfile.is_open()) {
-				for (i = 0; i < 8; i++) {
-					getline(myfile, line);
-					bpos = line.find(" ");
-					key = line.substr(0, bpos);
-					data = line.substr(bpos+1);
-					switch (i) {
-						case 0: version = stoi(data); break;
-						case 1: format = stoi(data); break;
-						case 2: vCount = stoi(data); break;
-						case 3: nCount = stoi(data); break;
-						case 4: tCount = stoi(data); break;
-						case 5: center = StrToVec3(data); break;
-						case 6: radius = stof(data); break;
-						case 7: id = data; break;
-					}
-				}
-
-				FreeMesh();
-				vertices = new Vec3[vCount];
-				normals = new Vec3[nCount];
-				triangles = new Triangle[tCount];
-
-				for (i = 0; i < vCount; i++) {
-					getline(myfile, line);
-					vertices[i] = StrToVec3(line);
-				}
-
-				for (i = 0; i < nCount; i++) {
-					getline(myfile, line);
-					normals[i] = StrToVec3(line);
-				}
-
-				if (format == 0) { // text format
-					for (i = 0; i < tCount; i++) {
-						getline(myfile, line);
-						bpos = line.find(",");
-						vi1 = stoi(line.substr(0, bpos));
-						line = line.substr(bpos+1);
-						bpos = line.find(",");
-						vi2 = stoi(line.substr(0, bpos));
-						vi3 = stoi(line.substr(bpos+1));
-						triangles[i].vertIndex[0] = vi1;
-						triangles[i].vertIndex[1] = vi2;
-						triangles[i].vertIndex[2] = vi3;
-						getline(myfile, line);
-						bpos = line.find(",");
-						if (bpos == string::npos) { // flat
-							triangles[i].type = 1;
-							triangles[i].normIndex[0] = stoi(line);
-						} else {
-							triangles[i].type = 0;
-							vi1 = stoi(line.substr(0, bpos));
-							line = line.substr(bpos+1);
-							bpos = line.find(",");
-							vi2 = stoi(line.substr(0, bpos));
-							vi3 = stoi(line.substr(bpos+1));
-							triangles[i].normIndex[0] = vi1;
-							triangles[i].normIndex[1] = vi2;
-							triangles[i].normIndex[2] = vi3;
-						}
-					}
-					for (i = 0; i < 8; i++) {
-						getline(myfile, line);	
-						boundBox[i] = StrToVec3(line);
-					}
-				} else if (format == 1) { // binary format
-					//TODO: read binary file
-				}
-
-				myfile.close();
-			} else {
-				throw 130;
-			}
-		} catch (int ecode) {
-			string emsg = ErrorCodeToStr(ecode)+filename;
-			HandleFatalError(ecode, emsg);
-		}
-	}
-	void CreateMemBuffer(cl::Context clc, cl_mem_flags flags=CL_MEM_READ_WRITE) {
-		triBuff = new cl::Buffer(clc, flags, sizeof(cl_Triangle)*tCount);
-		vertBuff = new cl::Buffer(clc, flags, sizeof(cl_float3)*vCount);
-		normBuff = new cl::Buffer(clc, flags, sizeof(cl_float3)*nCount);
-	}
-	void CopyToMemBuffer(cl::CommandQueue clq, cl_bool block=CL_TRUE) {
-		if (vertBuff != nullptr) {
-			clq.enqueueWriteBuffer(*vertBuff, block, 0, sizeof(cl_float3)*vCount, vertices);
-			clq.enqueueWriteBuffer(*triBuff, block, 0, sizeof(cl_Triangle)*tCount, triangles);
-		}
-		if (normBuff != nullptr) {
-			clq.enqueueWriteBuffer(*normBuff, block, 0, sizeof(cl_float3)*nCount, normals);
-		}
-	}
-	void DeleteMemBuffer() {
-		if (vertBuff != nullptr) {
-			delete vertBuff;
-			delete triBuff;
-			vertBuff = nullptr;
-			triBuff = nullptr;
-		}
-		if (normBuff != nullptr) {
-			delete normBuff;
-			normBuff = nullptr;
-		}	
-	}
-};
-
-class MeshSet {
-private:
-	vector<Mesh*> meshes;
-	vector<UINT32> lodMap;
-public:
-	UINT32 count;
-public:
-	MeshSet()
-	{
-		count = 0;
-	}
-	~MeshSet()
-	{
-		Clear();
-	}
-	void Clear()
-	{
-		if (count > 0) {
-			meshes.clear();
-			lodMap.clear();
-			count = 0;
-		}
-	}
-	Mesh* GetMesh(UINT32 index)
-	{
-		return meshes[index];
-	}
-	UINT32 CountLoDs(UINT32 index)
-	{
-		return lodMap[index];
-	}
-	void InsertMesh(Mesh* ot, UINT32 LoD)
-	{
-		meshes.push_back(ot);
-		lodMap.push_back(LoD);
-		count++;
-	}
-	void LoadMesh(const string filename)
-	{
-		ifstream meshfile(filename);
-		string mline, mkey, mdata;
-		UINT32 i, mvers, lc;
-		size_t mbpos;
-		string mdir, mid;
-
-		if (meshfile.is_open()) {
-
-			for (i = 0; i < 4; i++) {
-				getline(meshfile, mline);
-				mbpos = mline.find(" ");
-				mkey = mline.substr(0, mbpos);
-				mdata = mline.substr(mbpos+1);
-				switch (i) {
-					case 0: mvers = stoi(mdata); break;
-					case 1: lc = stoi(mdata); break;
-					case 2: mid = mdata; break;
-					case 3: mdir = mdata; break;
-				}
-			}
-
-			Mesh* mesh = new Mesh[lc];
-
-			for (i = 0; i < lc; i++) {
-				getline(meshfile, mline);
-				mesh[i].LoadMesh(mdir+mline);
-				mesh[i].id = mid+"_LoD"+IntToStr(i);
-				mesh[i].index = count;
-			}
-
-			InsertMesh(mesh, lc);
-			meshfile.close();
-		}
-	}
+#pragma once
+#include "MathExt.h"
+#include "Vec3.h"
+#include "Materials.h"
+#include "Triangles.h"
+#include "BVH.h"
+#include "ReadWrite.h"
+#include "CLTypes.h"
+#include "Compress.h"
+#include <string>
+#include <fstream>
+#include <assert.h>
+
+using namespace std;
+
+class Mesh
+{
+public:
+	cl::Buffer* vertBuff;
+	cl::Buffer* triBuff;
+	cl::Buffer* bvhBuff;
+	cl::Buffer* idxBuff;
+	Vec3 boundBox[8];
+	Vec3* vertices;
+	Vec3* normals;
+	Triangle* triangles;
+	BVH bvh;
+	string id;
+	UINT32 index;
+	bool quantized;
+	bool packed;
+	union {
+		cl_MeshInfo info;
+		struct {
+			UINT32 tCount;
+			UINT32 vCount;
+			UINT32 nCount;
+			float radius;
+			Vec3 center;
+			UINT32 vOffset;
+			UINT32 tOffset;
+			UINT32 bOffset;
+			UINT32 iOffset;
+		};
+	};
+public:
+	void InitMesh()
+	{
+		vertBuff = nullptr;
+		triBuff = nullptr;
+		bvhBuff = nullptr;
+		idxBuff = nullptr;
+		vertices = nullptr;
+		normals = nullptr;
+		triangles = nullptr;
+		vCount = 0;
+		nCount = 0;
+		tCount = 0;
+		radius = 0;
+		center = Vec3(0, 0, 0);
+		vOffset = 0;
+		tOffset = 0;
+		bOffset = 0;
+		iOffset = 0;
+		quantized = false;
+		packed = false;
+		id = "";
+	}
+	void FreeMesh()
+	{
+		if (vertices != nullptr)
+		{
+			delete[] vertices;
+		}
+		if (normals != nullptr)
+		{
+			delete[] normals;
+		}
+		if (triangles != nullptr)
+		{
+			delete[] triangles;
+		}
+		vertices = nullptr;
+		normals = nullptr;
+		triangles = nullptr;
+		bvh.Clear();
+	}
+	Mesh()
+	{
+		InitMesh();
+	}
+	Mesh(const string filename)
+	{
+		InitMesh();
+		Load(filename);
+	}
+	void LoadMesh(const string filename)
+	{
+		FreeMesh();
+		InitMesh();
+		Load(filename);
+	}
+	void Load(const string filename)
+	{
+		ifstream myfile(filename);
+		string line, key, data;
+		size_t bpos;
+		Vec3 tempVec;
+		UINT32 format, version;
+		UINT32 i, index = 0;
+		UINT32 vi1,vi2,vi3;
+		char tChar = '\n';
+		radius = 0;
+
+		try {
+			if (myfile.is_open()) {
+				for (i = 0; i < 8; i++) {
+					getline(myfile, line);
+					bpos = line.find(" ");
+					key = line.substr(0, bpos);
+					data = line.substr(bpos+1);
+					switch (i) {
+						case 0: version = stoi(data); break;
+						case 1: format = stoi(data); break;
+						case 2: vCount = stoi(data); break;
+						case 3: nCount = stoi(data); break;
+						case 4: tCount = stoi(data); break;
+						case 5: center = StrToVec3(data); break;
+						case 6: radius = stof(data); break;
+						case 7: id = data; break;
+					}
+				}
+
+				FreeMesh();
+				vertices = new Vec3[vCount];
+				normals = new Vec3[nCount];
+				triangles = new Triangle[tCount];
+
+				for (i = 0; i < vCount; i++) {
+					getline(myfile, line);
+					vertices[i] = StrToVec3(line);
+				}
+
+				for (i = 0; i < nCount; i++) {
+					getline(myfile, line);
+					normals[i] = StrToVec3(line);
+				}
+
+				if (format == 0) { // text format
+					for (i = 0; i < tCount; i++) {
+						getline(myfile, line);
+						bpos = line.find(",");
+						vi1 = stoi(line.substr(0, bpos));
+						line = line.substr(bpos+1);
+						bpos = line.find(",");
+						vi2 = stoi(line.substr(0, bpos));
+						vi3 = stoi(line.substr(bpos+1));
+						triangles[i].vertIndex[0] = vi1;
+						triangles[i].vertIndex[1] = vi2;
+						triangles[i].vertIndex[2] = vi3;
+						getline(myfile, line);
+						bpos = line.find(",");
+						if (bpos == string::npos) { // flat
+							triangles[i].type = 1;
+							triangles[i].normIndex[0] = stoi(line);
+						} else {
+							triangles[i].type = 0;
+							vi1 = stoi(line.substr(0, bpos));
+							line = line.substr(bpos+1);
+							bpos = line.find(",");
+							vi2 = stoi(line.substr(0, bpos));
+							vi3 = stoi(line.substr(bpos+1));
+							triangles[i].normIndex[0] = vi1;
+							triangles[i].normIndex[1] = vi2;
+							triangles[i].normIndex[2] = vi3;
+						}
+					}
+					for (i = 0; i < 8; i++) {
+						getline(myfile, line);	
+						boundBox[i] = StrToVec3(line);
+					}
+					BuildBVH();
+				} else if (format == 1) { // binary format
+					//TODO: read binary file
+				}
+
+				myfile.close();
+			} else {
+				throw 130;
+			}
+		} catch (int ecode) {
+			string emsg = ErrorCodeToStr(ecode)+filename;
+			HandleFatalError(ecode, emsg);
+		}
+	}
+	void BuildBVH()
+	{
+		AABB* bounds = new AABB[tCount];
+
+		// hierarchy is built in object space so it never needs rebuilding
+		for (UINT32 i = 0; i < tCount; i++) {
+			bounds[i].Grow(vertices[triangles[i].vertIndex[0]]);
+			bounds[i].Grow(vertices[triangles[i].vertIndex[1]]);
+			bounds[i].Grow(vertices[triangles[i].vertIndex[2]]);
+		}
+
+		bvh.Build(bounds, tCount);
+		delete[] bounds;
+	}
+	// 16 bit indexes can only reach the first 65536 vertices and normals
+	bool ShortIndexes() { return vCount <= 65536 && nCount <= 65536; }
+	// positions are stored relative to the cube around the bounding sphere, so the
+	// radius grows first if any vertex pokes out of it, normals follow as signed values
+	void QuantizeVerts(vector<cl_ushort4>& packed)
+	{
+		for (UINT32 i = 0; i < vCount; i++) {
+			Vec3 rel = vertices[i].VectSub(center);
+			radius = max(radius, max(fabs(rel.x), max(fabs(rel.y), fabs(rel.z))));
+		}
+
+		float scale = (radius > 0.0f) ? 0.5f / radius : 0.0f;
+
+		for (UINT32 i = 0; i < vCount; i++) {
+			Vec3 rel = vertices[i].VectSub(center) * scale;
+			float pos[3] = {rel.x, rel.y, rel.z};
+			cl_ushort4 pv = {};
+			for (UINT32 c = 0; c < 3; c++) {
+				pv.s[c] = (cl_ushort)(min(max(pos[c] + 0.5f, 0.0f), 1.0f) * 65535.0f + 0.5f);
+			}
+			packed.push_back(pv);
+		}
+
+		for (UINT32 i = 0; i < nCount; i++) {
+			float dir[3] = {normals[i].x, normals[i].y, normals[i].z};
+			cl_ushort4 pn = {};
+			for (UINT32 c = 0; c < 3; c++) {
+				pn.s[c] = (cl_ushort)(cl_short)roundf(min(max(dir[c], -1.0f), 1.0f) * 32767.0f);
+			}
+			packed.push_back(pn);
+		}
+	}
+	void PackTriangles(vector<cl_PackedTri>& packed)
+	{
+		for (UINT32 i = 0; i < tCount; i++) {
+			Triangle& tri = triangles[i];
+			cl_PackedTri pt;
+			for (UINT32 c = 0; c < 3; c++) {
+				pt.texMap[c].s[0] = FloatToHalf(tri.texmap[c].x);
+				pt.texMap[c].s[1] = FloatToHalf(tri.texmap[c].y);
+				pt.vertIndex[c] = (cl_ushort)tri.vertIndex[c];
+				pt.normIndex[c] = (cl_ushort)tri.normIndex[c];
+			}
+			pt.texIndex = (cl_ushort)tri.texIndex;
+			pt.matIndex = (cl_ushort)tri.matIndex;
+			pt.subIndex = (cl_ushort)tri.subIndex;
+			pt.type = (cl_ushort)tri.type;
+			packed.push_back(pt);
+		}
+	}
+	// intersection tests only need the vertex indexes, so they get their own stream
+	// after the triangles where each face is a quarter of a triangle record
+	template<typename T> void PackFaces(vector<T>& faces)
+	{
+		for (UINT32 i = 0; i < tCount; i++) {
+			T face = {};
+			face.s[0] = triangles[i].vertIndex[0];
+			face.s[1] = triangles[i].vertIndex[1];
+			face.s[2] = triangles[i].vertIndex[2];
+			faces.push_back(face);
+		}
+		faces.resize(FaceUnits()*4);
+	}
+	UINT32 FaceUnits() { return (tCount + 3) / 4; }
+	UINT32 TriUnits() { return tCount + FaceUnits(); }
+	UINT32 VertSize() { return quantized ? sizeof(cl_ushort4) : sizeof(cl_float3); }
+	UINT32 TriSize() { return packed ? sizeof(cl_PackedTri) : sizeof(cl_Triangle); }
+	// packed copies are temporary so these writes always block
+	void CopyTriangles(cl::CommandQueue clq, cl::Buffer& buffer, UINT32 offset)
+	{
+		if (tCount == 0) { return; }
+
+		size_t start = TriSize()*offset;
+		size_t faceStart = start + TriSize()*tCount;
+
+		if (packed) {
+			vector<cl_PackedTri> packedTris;
+			vector<cl_ushort4> faces;
+			PackTriangles(packedTris);
+			PackFaces(faces);
+			clq.enqueueWriteBuffer(buffer, CL_TRUE, start, TriSize()*tCount, packedTris.data());
+			clq.enqueueWriteBuffer(buffer, CL_TRUE, faceStart, TriSize()*FaceUnits(), faces.data());
+		} else {
+			vector<cl_uint4> faces;
+			PackFaces(faces);
+			clq.enqueueWriteBuffer(buffer, CL_TRUE, start, TriSize()*tCount, triangles);
+			clq.enqueueWriteBuffer(buffer, CL_TRUE, faceStart, TriSize()*FaceUnits(), faces.data());
+		}
+	}
+	void CreateMemBuffer(cl::Context clc, bool quant=false, bool pack=false, cl_mem_flags flags=CL_MEM_READ_WRITE) {
+		quantized = quant;
+		packed = pack;
+		triBuff = new cl::Buffer(clc, flags, TriSize()*max(TriUnits(), (UINT32)1));
+		bvhBuff = new cl::Buffer(clc, flags, sizeof(cl_BVHNode)*bvh.NodeCount());
+		idxBuff = new cl::Buffer(clc, flags, sizeof(cl_uint)*max(bvh.IndexCount(), (UINT32)1));
+		// normals are stored right after the vertices
+		vertBuff = new cl::Buffer(clc, flags, VertSize()*max(vCount+nCount, (UINT32)1));
+	}
+	void CopyToMemBuffer(cl::CommandQueue clq, cl_bool block=CL_TRUE) {
+		if (vertBuff != nullptr && quantized) {
+			vector<cl_ushort4> packedVerts;
+			QuantizeVerts(packedVerts);
+			if (packedVerts.size() > 0) {
+				clq.enqueueWriteBuffer(*vertBuff, CL_TRUE, 0, sizeof(cl_ushort4)*packedVerts.size(), packedVerts.data());
+			}
+			CopyTriangles(clq, *triBuff, 0);
+		} else if (vertBuff != nullptr) {
+			clq.enqueueWriteBuffer(*vertBuff, block, 0, sizeof(cl_float3)*vCount, vertices);
+			if (nCount > 0) {
+				clq.enqueueWriteBuffer(*vertBuff, block, sizeof(cl_float3)*vCount, sizeof(cl_float3)*nCount, normals);
+			}
+			CopyTriangles(clq, *triBuff, 0);
+		}
+		if (bvhBuff != nullptr) {
+			clq.enqueueWriteBuffer(*bvhBuff, block, 0, sizeof(cl_BVHNode)*bvh.NodeCount(), bvh.nodes.data());
+			if (bvh.IndexCount() > 0) {
+				clq.enqueueWriteBuffer(*idxBuff, block, 0, sizeof(cl_uint)*bvh.IndexCount(), bvh.indices.data());
+			}
+		}
+	}
+	void DeleteMemBuffer() {
+		if (vertBuff != nullptr) {
+			delete vertBuff;
+			delete triBuff;
+			vertBuff = nullptr;
+			triBuff = nullptr;
+		}
+		if (bvhBuff != nullptr) {
+			delete bvhBuff;
+			delete idxBuff;
+			bvhBuff = nullptr;
+			idxBuff = nullptr;
+		}
+	}
+};
+
+class MeshSet {
+private:
+	vector<Mesh*> meshes;
+	vector<UINT32> lodMap;
+public:
+	cl::Buffer* vertPool;
+	cl::Buffer* triPool;
+	cl::Buffer* bvhPool;
+	cl::Buffer* idxPool;
+	UINT32 count;
+public:
+	MeshSet()
+	{
+		vertPool = nullptr;
+		triPool = nullptr;
+		bvhPool = nullptr;
+		idxPool = nullptr;
+		count = 0;
+	}
+	~MeshSet()
+	{
+		Clear();
+	}
+	void Clear()
+	{
+		if (count > 0) {
+			meshes.clear();
+			lodMap.clear();
+			count = 0;
+		}
+	}
+	Mesh* GetMesh(UINT32 index)
+	{
+		return meshes[index];
+	}
+	UINT32 CountLoDs(UINT32 index)
+	{
+		return lodMap[index];
+	}
+	// triangles can only be packed if every mesh LoD fits 16 bit indexes
+	bool ShortIndexes()
+	{
+		for (UINT32 mi = 0; mi < count; mi++) {
+			for (UINT32 ml = 0; ml < lodMap[mi]; ml++) {
+				if (!meshes[mi][ml].ShortIndexes()) { return false; }
+			}
+		}
+		return true;
+	}
+	// packs every mesh LoD into shared buffers so one kernel can reach them all
+	void CreatePoolBuffers(cl::Context clc, bool quant=false, bool pack=false, cl_mem_flags flags=CL_MEM_READ_WRITE)
+	{
+		UINT32 vTotal = 0, tTotal = 0, bTotal = 0, iTotal = 0;
+
+		for (UINT32 mi = 0; mi < count; mi++) {
+			for (UINT32 ml = 0; ml < lodMap[mi]; ml++) {
+				Mesh& mesh = meshes[mi][ml];
+				mesh.quantized = quant;
+				mesh.packed = pack;
+				mesh.vOffset = vTotal;
+				mesh.tOffset = tTotal;
+				mesh.bOffset = bTotal;
+				mesh.iOffset = iTotal;
+				vTotal += mesh.vCount + mesh.nCount;
+				tTotal += mesh.TriUnits();
+				bTotal += mesh.bvh.NodeCount();
+				iTotal += mesh.bvh.IndexCount();
+			}
+		}
+
+		UINT32 vSize = quant ? sizeof(cl_ushort4) : sizeof(cl_float3);
+		UINT32 tSize = pack ? sizeof(cl_PackedTri) : sizeof(cl_Triangle);
+		vertPool = new cl::Buffer(clc, flags, vSize*max(vTotal, (UINT32)1));
+		triPool = new cl::Buffer(clc, flags, tSize*max(tTotal, (UINT32)1));
+		bvhPool = new cl::Buffer(clc, flags, sizeof(cl_BVHNode)*max(bTotal, (UINT32)1));
+		idxPool = new cl::Buffer(clc, flags, sizeof(cl_uint)*max(iTotal, (UINT32)1));
+	}
+	void CopyToPoolBuffers(cl::CommandQueue clq, cl_bool block=CL_TRUE)
+	{
+		if (vertPool == nullptr) { return; }
+
+		for (UINT32 mi = 0; mi < count; mi++) {
+			for (UINT32 ml = 0; ml < lodMap[mi]; ml++) {
+				Mesh& mesh = meshes[mi][ml];
+				if (mesh.quantized) {
+					// packed copies are temporary so these writes have to finish here
+					vector<cl_ushort4> packedVerts;
+					mesh.QuantizeVerts(packedVerts);
+					if (packedVerts.size() > 0) {
+						clq.enqueueWriteBuffer(*vertPool, CL_TRUE, sizeof(cl_ushort4)*mesh.vOffset, 
+											   sizeof(cl_ushort4)*packedVerts.size(), packedVerts.data());
+					}
+				} else {
+					if (mesh.vCount > 0) {
+						clq.enqueueWriteBuffer(*vertPool, block, sizeof(cl_float3)*mesh.vOffset, 
+											   sizeof(cl_float3)*mesh.vCount, mesh.vertices);
+					}
+					if (mesh.nCount > 0) {
+						clq.enqueueWriteBuffer(*vertPool, block, sizeof(cl_float3)*(mesh.vOffset+mesh.vCount), 
+											   sizeof(cl_float3)*mesh.nCount, mesh.normals);
+					}
+				}
+				mesh.CopyTriangles(clq, *triPool, mesh.tOffset);
+				if (mesh.bvh.NodeCount() > 0) {
+					clq.enqueueWriteBuffer(*bvhPool, block, sizeof(cl_BVHNode)*mesh.bOffset, 
+										   sizeof(cl_BVHNode)*mesh.bvh.NodeCount(), mesh.bvh.nodes.data());
+				}
+				if (mesh.bvh.IndexCount() > 0) {
+					clq.enqueueWriteBuffer(*idxPool, block, sizeof(cl_uint)*mesh.iOffset, 
+										   sizeof(cl_uint)*mesh.bvh.IndexCount(), mesh.bvh.indices.data());
+				}
+			}
+		}
+	}
+	void DeletePoolBuffers()
+	{
+		if (vertPool != nullptr) {
+			delete vertPool;
+			delete triPool;
+			delete bvhPool;
+			delete idxPool;
+			vertPool = nullptr;
+			triPool = nullptr;
+			bvhPool = nullptr;
+			idxPool = nullptr;
+		}
+	}
+	void InsertMesh(Mesh* ot, UINT32 LoD)
+	{
+		meshes.push_back(ot);
+		lodMap.push_back(LoD);
+		count++;
+	}
+	void LoadMesh(const string filename)
+	{
+		ifstream meshfile(filename);
+		string mline, mkey, mdata;
+		UINT32 i, mvers, lc;
+		size_t mbpos;
+		string mdir, mid;
+
+		if (meshfile.is_open()) {
+
+			for (i = 0; i < 4; i++) {
+				getline(meshfile, mline);
+				mbpos = mline.find(" ");
+				mkey = mline.substr(0, mbpos);
+				mdata = mline.substr(mbpos+1);
+				switch (i) {
+					case 0: mvers = stoi(mdata); break;
+					case 1: lc = stoi(mdata); break;
+					case 2: mid = mdata; break;
+					case 3: mdir = mdata; break;
+				}
+			}
+
+			Mesh* mesh = new Mesh[lc];
+
+			for (i = 0; i < lc; i++) {
+				getline(meshfile, mline);
+				mesh[i].LoadMesh(mdir+mline);
+				mesh[i].id = mid+"_LoD"+IntToStr(i);
+				mesh[i].index = count;
+			}
+
+			InsertMesh(mesh, lc);
+			meshfile.close();
+		}
+	}
 };
\ No newline at end of file
@@ -1,91 +1,143 @@
-#pragma once
-#include <string>
-#include <fstream>
-#include <assert.h>
-#include "Resource.h"
-#include "MathExt.h"
-
-using namespace std;
-
-static string ErrorCodeToStr(const int ecode) 
-{
-	string emsg;
-	switch (ecode)
-	{
-	case 060:
-		emsg = "Cannot locate font file:\n";
-		break;
-	case 130:
-		emsg = "Cannot locate mesh file:\n";
-		break;
-	case 110:
-		emsg = "Cannot locate material definition file:\n";
-		break;
-	case 150:
-		emsg = "Cannot locate texture map file:\n";
-		break;
-	case 151:
-		emsg = "Invalid LoD for texture map file:\n";
-		break;
-	case 200:
-		emsg = "Cannot locate texture file:\n";
-		break;
-	default:
-		emsg = "n/a";
-		break;
-	}
-	return emsg;
-}
-
-static void HandleFatalError(const int ecode, string emsg)
-{
-	wstring wemsg = StrToWstr(emsg);
-	HWND wHandle = GetForegroundWindow();
-
-    int msgboxID = MessageBox(
-        wHandle,
-        (LPCWSTR)(L"The application encountered a fatal error and needs to close.\n\nError message: "+wemsg).c_str(),
-        (LPCWSTR)(L"Fatal Error ("+IntToWstr(ecode)+L")").c_str(), MB_ICONERROR | MB_OK | MB_SYSTEMMODAL | MB_SETFOREGROUND
-    );
-
-	exit(EXIT_FAILURE);
-}
-
-static string readFile(const string filename) 
-{
-	ifstream sourceFile(filename);
-    string sourceCode(istreambuf_iterator<char>(sourceFile),(istreambuf_iterator<char>()));
-	return sourceCode;
-}
-
-static void LoadConfigFile(const string filename)
-{
-	ifstream levelfile(filename);
-	string line, key, data;
-	size_t bpos;
-
-	if (levelfile.is_open()) {
-
-		while (!levelfile.eof()) {
-			getline(levelfile, line);
-			bpos = line.find("=");
-			if (bpos == string::npos) { continue; }
-			key = line.substr(0, bpos);
-			data = line.substr(bpos+1);
-			GLOBALS::config_map[key] = data;
-		}
-
-		levelfile.close();
-	}
-}
-
-static void CLBLog(const string logstr) 
-{
-	if (CL_COMPLOG) {
-		ofstream clfile("logs\\cl_cout.log", ofstream::app);
-		if (clfile.is_open()) {
-			clfile << logstr.c_str() << "\n";
-			clfile.close();
-		}
-	}
+#pragma once
+#include <string>
+#include <fstream>
+#include <vector>
+#include <assert.h>
+#include "Resource.h"
+#include "MathExt.h"
+
+using namespace std;
+
+static string ErrorCodeToStr(const int ecode) 
+{
+	string emsg;
+	switch (ecode)
+	{
+	case 060:
+		emsg = "Cannot locate font file:\n";
+		break;
+	case 130:
+		emsg = "Cannot locate mesh file:\n";
+		break;
+	case 110:
+		emsg = "Cannot locate material definition file:\n";
+		break;
+	case 150:
+		emsg = "Cannot locate texture map file:\n";
+		break;
+	case 151:
+		emsg = "Invalid LoD for texture map file:\n";
+		break;
+	case 152:
+		emsg = "Normal map does not survive packing:\n";
+		break;
+	case 200:
+		emsg = "Cannot locate texture file:\n";
+		break;
+	default:
+		emsg = "n/a";
+		break;
+	}
+	return emsg;
+}
+
+static void HandleFatalError(const int ecode, string emsg)
+{
+	wstring wemsg = StrToWstr(emsg);
+	HWND wHandle = GetForegroundWindow();
+
+    int msgboxID = MessageBox(
+        wHandle,
+        (LPCWSTR)(L"The application encountered a fatal error and needs to close.\n\nError message: "+wemsg).c_str(),
+        (LPCWSTR)(L"Fatal Error ("+IntToWstr(ecode)+L")").c_str(), MB_ICONERROR | MB_OK | MB_SYSTEMMODAL | MB_SETFOREGROUND
+    );
+
+	exit(EXIT_FAILURE);
+}
+
+static string readFile(const string filename) 
+{
+	ifstream sourceFile(filename);
+    string sourceCode(istreambuf_iterator<char>(sourceFile),(istreambuf_iterator<char>()));
+	return sourceCode;
+}
+
+// 64 bit FNV-1a hash, used to key cached program binaries
+static unsigned long long HashString(const string& str)
+{
+	unsigned long long hash = 14695981039346656037ULL;
+	for (size_t i = 0; i < str.length(); i++) {
+		hash ^= (unsigned char)str[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+static string HashToStr(unsigned long long hash)
+{
+	const char* digits = "0123456789abcdef";
+	string result(16, '0');
+	for (int i = 15; i >= 0; i--, hash >>= 4) { result[i] = digits[hash & 15]; }
+	return result;
+}
+
+// binary files start with the key they were written for, false if it does not match
+static bool readBinaryFile(const string filename, const string& key, vector<unsigned char>& data)
+{
+	ifstream binFile(filename, ifstream::binary);
+	if (!binFile.is_open()) { return false; }
+
+	UINT32 keyLength = 0;
+	binFile.read((char*)&keyLength, sizeof(keyLength));
+	if (!binFile || keyLength != key.length()) { return false; }
+
+	string fileKey(keyLength, '\0');
+	binFile.read(&fileKey[0], keyLength);
+	if (!binFile || fileKey != key) { return false; }
+
+	data.assign(istreambuf_iterator<char>(binFile), istreambuf_iterator<char>());
+	return !data.empty();
+}
+
+static void writeBinaryFile(const string filename, const string& key, const vector<unsigned char>& data)
+{
+	ofstream binFile(filename, ofstream::binary | ofstream::trunc);
+	if (!binFile.is_open()) { return; }
+
+	UINT32 keyLength = key.length();
+	binFile.write((const char*)&keyLength, sizeof(keyLength));
+	binFile.write(key.c_str(), keyLength);
+	binFile.write((const char*)data.data(), data.size());
+}
+
+static void LoadConfigFile(const string filename)
+{
+	ifstream levelfile(filename);
+	string line, key, data;
+	size_t bpos;
+
+	if (levelfile.is_open()) {
+
+		while (!levelfile.eof()) {
+			getline(levelfile, line);
+			bpos = line.find("=");
+			if (bpos == string::npos) { continue; }
+			key = line.substr(0, bpos);
+			data = line.substr(bpos+1);
+			GLOBALS::config_map[key] = data;
+		}
+
+		levelfile.close();
+	}
+}
+
+static void CLBLog(const string logstr) 
+{
+	if (CL_COMPLOG) {
+		ofstream clfile("logs\\cl_cout.log", ofstream::app);
+		if (clfile.is_open()) {
+			clfile << logstr.c_str() << "\n";
+			clfile.close();
+		}
+	}
 }
\ No newline at end of file
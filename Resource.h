@@ -1,32 +1,57 @@
-#pragma once 
-#include <string>
-#include <unordered_map>
-#include "CLTypes.h"
-
-#define CAMSPIN_SPEED	0.001
-#define CAMMOVE_SPEED	1
-
-#define OBJECT_TYPES	9
-#define LIGHTS_INDEX	8
-#define MAX_OBJECTS		999
-
-#define CL_LOGGING		1
-#define CL_COMPLOG		1
-
-#define WINDOW_TITLE	"Pray Engine (OpenCL+OpenGL)"
-
-#if defined (__APPLE__) || defined(MACOSX)
-	#define CL_GL_SHARING_EXT "cl_APPLE_gl_sharing"
-#else
-	#define CL_GL_SHARING_EXT "cl_khr_gl_sharing"
-#endif
-
-namespace GLOBALS {
-
-	extern std::unordered_map<std::string,std::string> config_map;
-
-	const cl_AAInfo AA_X1  = {1,   1,   1.0,   1.0};
-	const cl_AAInfo AA_X4  = {4,   2,   0.5,   0.25};
-	const cl_AAInfo AA_X9  = {9,   3,   1./3,  1./6};
-	const cl_AAInfo AA_X16 = {16,  4,   0.25,  0.125};
+#pragma once 
+#include <string>
+#include <unordered_map>
+#include "CLTypes.h"
+
+#define CAMSPIN_SPEED	0.001
+#define CAMMOVE_SPEED	1
+
+#define OBJECT_TYPES	9
+#define LIGHTS_INDEX	8
+#define MAX_OBJECTS		999
+
+#define BVH_SAH_BINS	12
+#define BVH_MAX_LEAF	4
+#define BVH_MAX_DEPTH	31 // keep below BVH_STACK_SIZE in compute.cl
+
+#define RENDER_OBJECTS	0
+#define RENDER_SCENE	1
+#define RENDER_WAVEFRONT	2
+#define RENDER_TILED	3
+
+#define WAVE_SCAN_SIZE	256 // must match SCAN_SIZE in compute.cl
+#define PERSIST_SIZE	64
+#define TILE_STATS_FRAMES	300
+#define FRAME_STATS_FRAMES	300
+
+#define TEX_BC1			1 // must match TEX_BC1 in compute.cl
+#define TEX_BC3			3 // must match TEX_BC3 in compute.cl
+#define OCT_MAX_ERROR	0.0002f // normal map texels may turn about 0.01 degrees when packed
+
+#define CLUSTER_SIZE	32
+#define CLUSTER_SLICES	16
+#define CLUSTER_LIGHTS	32 // must match CLUSTER_LIGHTS in compute.cl
+#define CLUSTER_NEAR	10.0f
+
+#define TEMPORAL_JITTER	8 // frames before the sub-pixel offsets repeat
+
+#define CL_LOGGING		1
+#define CL_COMPLOG		1
+
+#define WINDOW_TITLE	"Pray Engine (OpenCL+OpenGL)"
+
+#if defined (__APPLE__) || defined(MACOSX)
+	#define CL_GL_SHARING_EXT "cl_APPLE_gl_sharing"
+#else
+	#define CL_GL_SHARING_EXT "cl_khr_gl_sharing"
+#endif
+
+namespace GLOBALS {
+
+	extern std::unordered_map<std::string,std::string> config_map;
+
+	const cl_AAInfo AA_X1  = {1,   1,   1.0,   1.0};
+	const cl_AAInfo AA_X4  = {4,   2,   0.5,   0.25};
+	const cl_AAInfo AA_X9  = {9,   3,   1./3,  1./6};
+	const cl_AAInfo AA_X16 = {16,  4,   0.25,  0.125};
 }
\ No newline at end of file
@@ -1,270 +1,394 @@
-#pragma once
-#include "Colors.h"
-#include "MathExt.h"
-#include "Vec3.h"
-#include "ReadWrite.h"
-#include "CLTypes.h"
-#include <string>
-#include <fstream>
-#include <assert.h>
-#include <gdiplus.h>
-
-using namespace std;
-
-struct Surface
-{
-	RGB32* colors;
-	union {
-		cl_SurfInfo info;
-		struct {
-			UINT32 layers;
-			UINT32 height;
-			UINT32 width;
-			UINT32 count;
-		};
-	};
-};
-
-struct Surf24
-{
-	RGB24* colors;
-	union {
-		cl_SurfInfo info;
-		struct {
-			UINT32 layers;
-			UINT32 height;
-			UINT32 width;
-			UINT32 count;
-		};
-	};
-};
-
-struct Vec3Surf
-{
-	Vec3* vectors;
-	union {
-		cl_SurfInfo info;
-		struct {
-			UINT32 layers;
-			UINT32 height;
-			UINT32 width;
-			UINT32 count;
-		};
-	};
-};
-
-class Texture
-{
-public:
-	cl::Buffer* texBuff;
-	cl::Buffer* normBuff;
-	Surface surface;
-	Vec3Surf normalMap;
-	bool hasNormMap;
-	string id;
-	UINT32 index;
-public:
-	Texture()
-	{
-		InitTexture();
-	}
-	~Texture()
-	{
-		DeleteMemBuffer();
-	}
-	void InitTexture() 
-	{
-		texBuff = nullptr;
-		normBuff = nullptr;
-		hasNormMap = false;
-		index = 0;
-		id = "";
-	}
-	void LoadTexture(const string filename)
-	{
-		surface = LoadSurface(filename);
-	}
-	void LoadNormalMap(const string filename)
-	{
-		normalMap = LoadNormMap(filename);
-	}
-	Surface LoadSurface(const string filename)
-	{
-		try {
-			ifstream file(filename);
-			if (file.is_open()) {
-				file.close();
-				Gdiplus::Bitmap bitmap( StrToWstr(filename).c_str() );
-				Gdiplus::Color pixel;
-
-				Surface surf;
-				surf.width = bitmap.GetWidth();
-				surf.height = bitmap.GetHeight();
-				surf.count = surf.width * surf.height;
-				surf.colors = new RGB32[surf.count];
-				surf.layers = 1;// TODO: multi-layer surfaces
-
-				int yy=0;
-
-				for ( int y = surf.height-1; y >= 0; y-- ) {
-					for ( UINT32 x = 0; x < surf.width; x++ )
-					{
-						bitmap.GetPixel( x,y,&pixel );
-						surf.colors[ x + yy * surf.width ] = CREATE_ARGB32(pixel.GetR(), pixel.GetG(), pixel.GetB(), pixel.GetA());
-					}
-					yy++;
-				}
-
-				return surf;
-			} else {
-				throw 200;
-			}
-		} catch (int ecode) {
-			string emsg = ErrorCodeToStr(ecode)+filename;
-			HandleFatalError(ecode, emsg);
-		}
-	}
-	Vec3Surf LoadNormMap(const string filename)
-	{
-		try {
-			ifstream file(filename);
-			if (file.is_open()) {
-				file.close();
-				Gdiplus::Bitmap bitmap( StrToWstr(filename).c_str() );
-				Gdiplus::Color pixel;
-
-				Vec3Surf surf;
-				surf.width = bitmap.GetWidth();
-				surf.height = bitmap.GetHeight();
-				surf.count = surf.width * surf.height;
-				surf.vectors = new Vec3[surf.count];
-				surf.layers = 1;// TODO: multi-layer surfaces
-
-				int yy=0;
-
-				for( int y = surf.height-1; y >= 0; y-- ) {
-					for( UINT32 x = 0; x < surf.width; x++ )
-					{
-						bitmap.GetPixel( x,y,&pixel );
-						surf.vectors[ x + yy * surf.width ] = RGBNtoVec3(CREATE_RGB24(pixel.GetR(), pixel.GetG(), pixel.GetB()));
-					}
-					yy++;
-				}
-
-				return surf;
-			} else {
-				throw 200;
-			}
-		} catch (int ecode) {
-			string emsg = ErrorCodeToStr(ecode)+filename;
-			HandleFatalError(ecode, emsg);
-		}
-	}
-	void CreateMemBuffer(cl::Context clc, cl_mem_flags flags=CL_MEM_READ_WRITE) {
-		texBuff = new cl::Buffer(clc, flags, sizeof(cl_RGB32)*surface.count);
-		if (hasNormMap) {
-			normBuff = new cl::Buffer(clc, flags, sizeof(cl_float3)*normalMap.count);
-		} else {
-			normBuff = nullptr;
-		}
-	}
-	void CopyToMemBuffer(cl::CommandQueue clq, cl_bool block=CL_TRUE) {
-		if (texBuff != nullptr) {
-			clq.enqueueWriteBuffer(*texBuff, block, 0, sizeof(cl_RGB32)*surface.count, surface.colors);
-		}
-		if (normBuff != nullptr) {
-			clq.enqueueWriteBuffer(*normBuff, block, 0, sizeof(cl_float3)*normalMap.count, normalMap.vectors);
-		}
-	}
-	void DeleteMemBuffer() {
-		if (texBuff != nullptr) {
-			delete texBuff;
-			texBuff = nullptr;
-		}
-		if (normBuff != nullptr) {
-			delete normBuff;
-			normBuff = nullptr;
-		}		
-	}
-};
-
-
-class TextureSet {
-private:
-	vector<Texture*> textures;
-	vector<UINT32> lodMap;
-public:
-	UINT32 count;
-public:
-	TextureSet()
-	{
-		count = 0;
-	}
-	~TextureSet()
-	{
-		Clear();
-	}
-	void Clear()
-	{
-		textures.clear();
-		lodMap.clear();
-		count = 0;
-	}
-	Texture* GetTexture(UINT32 index)
-	{
-		return textures[index];
-	}
-	UINT32 CountLoDs(UINT32 index)
-	{
-		return lodMap[index];
-	}
-	void InsertTexture(Texture* ot, UINT32 LoD)
-	{
-		textures.push_back(ot);
-		lodMap.push_back(LoD);
-		count++;
-	}
-	void LoadTexture(const string filename)
-	{
-		ifstream textfile(filename);
-		string tline, tkey, tdata;
-		UINT32 i, l, lc, tvers;
-		size_t tbpos;
-		string tdir, tid;
-
-		if (textfile.is_open()) {
-
-			for (i = 0; i < 4; i++) {
-				getline(textfile, tline);
-				tbpos = tline.find(" ");
-				tkey = tline.substr(0, tbpos);
-				tdata = tline.substr(tbpos+1);
-				switch (i) {
-					case 0: tvers = stoi(tdata); break;
-					case 1: lc = stoi(tdata); break;
-					case 2: tid = tdata; break;
-					case 3: tdir = tdata; break;
-				}
-			}
-
-			Texture* newText = new Texture[lc];
-
-			for (l = 0; l < lc; l++) {
-				newText[l].id = tid+"_LoD"+IntToStr(l);
-				getline(textfile, tline);
-				newText[l].LoadTexture(tdir+tline);
-				getline(textfile, tline);
-				if (tline != "null") {
-					newText[l].LoadNormalMap(tdir+tline);
-					newText[l].hasNormMap = true;
-				} else {
-					newText[l].hasNormMap = false;
-				}
-				newText[l].index = count;
-			}
-
-			InsertTexture(newText, lc);
-			textfile.close();
-		}
-	}
+#pragma once
+#include "Colors.h"
+#include "MathExt.h"
+#include "Vec3.h"
+#include "ReadWrite.h"
+#include "CLTypes.h"
+#include "Compress.h"
+#include <string>
+#include <fstream>
+#include <assert.h>
+#include <gdiplus.h>
+
+using namespace std;
+
+struct Surface
+{
+	RGB32* colors;
+	union {
+		cl_SurfInfo info;
+		struct {
+			UINT32 layers;
+			UINT32 height;
+			UINT32 width;
+			UINT32 count;
+		};
+	};
+};
+
+struct Surf24
+{
+	RGB24* colors;
+	union {
+		cl_SurfInfo info;
+		struct {
+			UINT32 layers;
+			UINT32 height;
+			UINT32 width;
+			UINT32 count;
+		};
+	};
+};
+
+struct OctSurf
+{
+	cl_ushort2* normals;
+	union {
+		cl_SurfInfo info;
+		struct {
+			UINT32 layers;
+			UINT32 height;
+			UINT32 width;
+			UINT32 count;
+		};
+	};
+};
+
+class Texture
+{
+public:
+	cl::Buffer* normBuff;
+	Surface surface;
+	OctSurf normalMap;
+	cl_TexInfo texInfo;
+	bool hasNormMap;
+	bool hasAlpha;
+	string id;
+	UINT32 index;
+public:
+	Texture()
+	{
+		InitTexture();
+	}
+	~Texture()
+	{
+		DeleteMemBuffer();
+	}
+	void InitTexture() 
+	{
+		normBuff = nullptr;
+		texInfo = {};
+		hasNormMap = false;
+		hasAlpha = false;
+		index = 0;
+		id = "";
+	}
+	void LoadTexture(const string filename)
+	{
+		surface = LoadSurface(filename);
+		// opaque textures never need sampling to find hit opacity
+		hasAlpha = false;
+		for (UINT32 i = 0; i < surface.count && !hasAlpha; i++) {
+			hasAlpha = surface.colors[i].alpha < 255;
+		}
+	}
+	void LoadNormalMap(const string filename)
+	{
+		normalMap = LoadNormMap(filename);
+	}
+	Surface LoadSurface(const string filename)
+	{
+		try {
+			ifstream file(filename);
+			if (file.is_open()) {
+				file.close();
+				Gdiplus::Bitmap bitmap( StrToWstr(filename).c_str() );
+				Gdiplus::Color pixel;
+
+				Surface surf;
+				surf.width = bitmap.GetWidth();
+				surf.height = bitmap.GetHeight();
+				surf.count = surf.width * surf.height;
+				surf.colors = new RGB32[surf.count];
+				surf.layers = 1;// TODO: multi-layer surfaces
+
+				int yy=0;
+
+				for ( int y = surf.height-1; y >= 0; y-- ) {
+					for ( UINT32 x = 0; x < surf.width; x++ )
+					{
+						bitmap.GetPixel( x,y,&pixel );
+						surf.colors[ x + yy * surf.width ] = CREATE_ARGB32(pixel.GetR(), pixel.GetG(), pixel.GetB(), pixel.GetA());
+					}
+					yy++;
+				}
+
+				return surf;
+			} else {
+				throw 200;
+			}
+		} catch (int ecode) {
+			string emsg = ErrorCodeToStr(ecode)+filename;
+			HandleFatalError(ecode, emsg);
+		}
+	}
+	// texels go straight from 8 bit channels to packed octahedral normals
+	OctSurf LoadNormMap(const string filename)
+	{
+		try {
+			ifstream file(filename);
+			if (file.is_open()) {
+				file.close();
+				Gdiplus::Bitmap bitmap( StrToWstr(filename).c_str() );
+				Gdiplus::Color pixel;
+
+				OctSurf surf;
+				surf.width = bitmap.GetWidth();
+				surf.height = bitmap.GetHeight();
+				surf.count = surf.width * surf.height;
+				surf.normals = new cl_ushort2[surf.count];
+				surf.layers = 1;// TODO: multi-layer surfaces
+
+				int yy=0;
+				float worst = 0.0f;
+
+				for( int y = surf.height-1; y >= 0; y-- ) {
+					for( UINT32 x = 0; x < surf.width; x++ )
+					{
+						bitmap.GetPixel( x,y,&pixel );
+						float nx = pixel.GetR()/127.5f-1.0f, ny = pixel.GetG()/127.5f-1.0f, nz = pixel.GetB()/127.5f-1.0f;
+						surf.normals[ x + yy * surf.width ] = OctEncode(nx, ny, nz);
+						worst = max(worst, OctError(nx, ny, nz));
+					}
+					yy++;
+				}
+
+				// every texel is decoded again so a broken encoder stops here instead of bending normals
+				if (worst > OCT_MAX_ERROR) { throw 152; }
+
+				return surf;
+			} else {
+				throw 200;
+			}
+		} catch (int ecode) {
+			string emsg = ErrorCodeToStr(ecode)+filename;
+			HandleFatalError(ecode, emsg);
+		}
+	}
+	// colors live in the texture pool image, only the normal map gets its own buffer
+	void CreateMemBuffer(cl::Context clc, cl_mem_flags flags=CL_MEM_READ_WRITE) {
+		if (hasNormMap) {
+			normBuff = new cl::Buffer(clc, flags, sizeof(cl_ushort2)*normalMap.count);
+		} else {
+			normBuff = nullptr;
+		}
+	}
+	void CopyToMemBuffer(cl::CommandQueue clq, cl_bool block=CL_TRUE) {
+		if (normBuff != nullptr) {
+			clq.enqueueWriteBuffer(*normBuff, block, 0, sizeof(cl_ushort2)*normalMap.count, normalMap.normals);
+		}
+	}
+	void DeleteMemBuffer() {
+		if (normBuff != nullptr) {
+			delete normBuff;
+			normBuff = nullptr;
+		}		
+	}
+};
+
+
+class TextureSet {
+private:
+	vector<Texture*> textures;
+	vector<UINT32> lodMap;
+	vector<cl_uint2> blocks;
+public:
+	cl::Image2DArray* texPool;
+	cl::Buffer* blockPool;
+	UINT32 count;
+public:
+	TextureSet()
+	{
+		texPool = nullptr;
+		blockPool = nullptr;
+		count = 0;
+	}
+	~TextureSet()
+	{
+		Clear();
+	}
+	void Clear()
+	{
+		textures.clear();
+		lodMap.clear();
+		blocks.clear();
+		count = 0;
+	}
+	Texture* GetTexture(UINT32 index)
+	{
+		return textures[index];
+	}
+	UINT32 CountLoDs(UINT32 index)
+	{
+		return lodMap[index];
+	}
+	// packs each texture into one layer of an image array, the first LoD on the
+	// left and the smaller LoDs stacked beside it like a mip chain, or into a
+	// buffer of 4x4 blocks with each LoD following the last when compressed
+	void CreatePoolBuffers(cl::Context clc, bool compress=false, cl_mem_flags flags=CL_MEM_READ_ONLY)
+	{
+		UINT32 poolWidth = 1, poolHeight = 1;
+
+		for (UINT32 ti = 0; ti < count; ti++) {
+			Surface& base = textures[ti][0].surface;
+			cl_TexInfo info = {};
+			info.width = base.width;
+			info.height = base.height;
+			info.layer = ti;
+			info.levels = lodMap[ti];
+
+			if (compress) {
+				info.offset = (UINT32)blocks.size();
+				info.format = textures[ti][0].hasAlpha ? TEX_BC3 : TEX_BC1;
+				for (UINT32 tl = 0; tl < lodMap[ti]; tl++) {
+					Surface& surf = textures[ti][tl].surface;
+					CompressSurface(surf.colors, surf.width, surf.height, info.format, blocks);
+				}
+			}
+
+			// kernels pick the level for each hit so every LoD shares the same info
+			for (UINT32 tl = 0; tl < lodMap[ti]; tl++) {
+				textures[ti][tl].texInfo = info;
+			}
+
+			poolWidth = max(poolWidth, base.width + ((lodMap[ti] > 1) ? base.width/2 : 0));
+			poolHeight = max(poolHeight, base.height);
+		}
+
+		if (compress) {
+			blockPool = new cl::Buffer(clc, flags, sizeof(cl_uint2)*max((UINT32)blocks.size(), (UINT32)1));
+			return;
+		}
+
+		// stored as BGRA to match the RGB32 byte order
+		texPool = new cl::Image2DArray(clc, flags, cl::ImageFormat(CL_BGRA, CL_UNORM_INT8), 
+									   max(count, (UINT32)1), poolWidth, poolHeight, 0, 0);
+	}
+	void CopyToPoolBuffers(cl::CommandQueue clq, cl_bool block=CL_TRUE)
+	{
+		if (blockPool != nullptr && blocks.size() > 0) {
+			clq.enqueueWriteBuffer(*blockPool, block, 0, sizeof(cl_uint2)*blocks.size(), blocks.data());
+		}
+
+		if (texPool == nullptr) { return; }
+
+		for (UINT32 ti = 0; ti < count; ti++) {
+			for (UINT32 tl = 0; tl < lodMap[ti]; tl++) {
+				Texture& text = textures[ti][tl];
+				if (text.surface.count > 0) {
+					// same placement as TexLevel in compute.cl
+					cl::size_t<3> origin, region;
+					origin[0] = (tl > 0) ? text.texInfo.width : 0;
+					origin[1] = (tl > 0) ? text.texInfo.height - (text.texInfo.height >> (tl-1)) : 0;
+					origin[2] = text.texInfo.layer;
+					region[0] = text.surface.width; region[1] = text.surface.height; region[2] = 1;
+					clq.enqueueWriteImage(*texPool, block, origin, region, 0, 0, text.surface.colors);
+				}
+			}
+		}
+	}
+	void DeletePoolBuffers()
+	{
+		if (texPool != nullptr) {
+			delete texPool;
+			texPool = nullptr;
+		}
+		if (blockPool != nullptr) {
+			delete blockPool;
+			blockPool = nullptr;
+		}
+	}
+	// kernels take whichever pool was created
+	cl::Memory& PoolMemory()
+	{
+		if (blockPool != nullptr) { return *blockPool; }
+		return *texPool;
+	}
+	// quality and size of the compressed pool against the raw texels
+	void ReportCompression()
+	{
+		size_t rawBytes = 0;
+
+		for (UINT32 ti = 0; ti < count; ti++) {
+			cl_TexInfo& info = textures[ti][0].texInfo;
+			UINT32 offset = info.offset;
+			for (UINT32 tl = 0; tl < lodMap[ti]; tl++) {
+				Surface& surf = textures[ti][tl].surface;
+				UINT32 units = (info.format == TEX_BC3) ? 2 : 1;
+				double psnr = CompressedPSNR(surf.colors, surf.width, surf.height, info.format, blocks.data() + offset);
+				cout << "Texture "+textures[ti][tl].id+" LoD "+IntToStr(tl)+": "+(units == 2 ? "BC3" : "BC1");
+				cout << ", PSNR "+DblToStr(psnr)+" dB\n";
+				offset += ((surf.width + 3) / 4) * ((surf.height + 3) / 4) * units;
+				rawBytes += surf.count * sizeof(RGB32);
+			}
+		}
+
+		size_t packedBytes = blocks.size() * sizeof(cl_uint2);
+		cout << "Texture pool: "+IntToStr((UINT32)rawBytes)+" bytes raw, "+IntToStr((UINT32)packedBytes)+" bytes compressed";
+		cout << ", ratio "+DblToStr(packedBytes ? (double)rawBytes/packedBytes : 0.0)+"\n";
+	}
+	void InsertTexture(Texture* ot, UINT32 LoD)
+	{
+		textures.push_back(ot);
+		lodMap.push_back(LoD);
+		count++;
+	}
+	void LoadTexture(const string filename)
+	{
+		ifstream textfile(filename);
+		string tline, tkey, tdata;
+		UINT32 i, l, lc, tvers;
+		size_t tbpos;
+		string tdir, tid;
+
+		if (textfile.is_open()) {
+
+			for (i = 0; i < 4; i++) {
+				getline(textfile, tline);
+				tbpos = tline.find(" ");
+				tkey = tline.substr(0, tbpos);
+				tdata = tline.substr(tbpos+1);
+				switch (i) {
+					case 0: tvers = stoi(tdata); break;
+					case 1: lc = stoi(tdata); break;
+					case 2: tid = tdata; break;
+					case 3: tdir = tdata; break;
+				}
+			}
+
+			Texture* newText = new Texture[lc];
+
+			for (l = 0; l < lc; l++) {
+				newText[l].id = tid+"_LoD"+IntToStr(l);
+				getline(textfile, tline);
+				newText[l].LoadTexture(tdir+tline);
+				// each LoD must be exactly half the previous one to work as a mip level
+				if (l > 0 && (newText[l].surface.width != newText[l-1].surface.width/2 || 
+					newText[l].surface.height != newText[l-1].surface.height/2 || newText[l].surface.count == 0)) {
+					HandleFatalError(151, ErrorCodeToStr(151)+tdir+tline);
+				}
+				getline(textfile, tline);
+				if (tline != "null") {
+					newText[l].LoadNormalMap(tdir+tline);
+					newText[l].hasNormMap = true;
+				} else {
+					newText[l].hasNormMap = false;
+				}
+				newText[l].index = count;
+			}
+
+			InsertTexture(newText, lc);
+			textfile.close();
+		}
+	}
 };
\ No newline at end of file
@@ -1,17 +1,17 @@
-#pragma once
-
-#include <windows.h>
-
-class Timer
-{
-public:
-	Timer();
-	void StartWatch();
-	void StopWatch();
-	float GetTimeMilli() const;
-private:
-	float invFreqMilli;
-	bool watchStopped;
-	unsigned long long currentCount;
-	unsigned long long startCount;
+#pragma once
+
+#include <windows.h>
+
+class Timer
+{
+public:
+	Timer();
+	void StartWatch();
+	void StopWatch();
+	float GetTimeMilli() const;
+private:
+	float invFreqMilli;
+	bool watchStopped;
+	unsigned long long currentCount;
+	unsigned long long startCount;
 };
\ No newline at end of file
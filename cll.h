@@ -1,168 +1,353 @@
-#pragma once
-#define __CL_ENABLE_EXCEPTIONS
-#include <CL/cl.hpp>
-#include "ReadWrite.h"
-#include "MathExt.h"
-#include <stdio.h>
-#include <cstdlib>
-#include <string>
-#include <iostream>
-
-#ifdef linux
-    #include <GL/glx.h>
-#endif
-
-class CL
-{
-private:
-	cl::Platform platform;
-	cl::Device device;
-	cl::Program program;
-public:
-	cl::NDRange local_range;
-	cl::CommandQueue queue;
-	cl::Context context;
-	cl::Kernel CR_Kernel;
-	cl::Kernel CS_Kernel;
-	cl::Kernel CT_Kernel;
-	cl::Kernel CL_Kernel;
-	UINT32 max_wg_size;
-public:
-	void Initialize(unsigned char sub_rays, unsigned char t_depth)
-	{
-		cout << "Initializing OpenCL ... ";
-
-		// get all platforms (drivers)
-		vector<cl::Platform> all_platforms;
-		cl::Platform::get(&all_platforms);
-		if (all_platforms.size()==0) {
-			HandleFatalError(30, "No platforms found. Check OpenCL installation!");
-		}
-		// select default platform
-		platform=all_platforms[0];
-
-		#ifdef linux
-			cl_context_properties props[] = {
-			CL_GL_CONTEXT_KHR, (cl_context_properties) glXGetCurrentContext(),
-			CL_GLX_DISPLAY_KHR, (cl_context_properties) glXGetCurrentDisplay(),
-			CL_CONTEXT_PLATFORM, (cl_context_properties)(platform)(), 0};
-		#elif defined WIN32 || defined _WIN32
-			cl_context_properties props[] = {
-			CL_GL_CONTEXT_KHR, (cl_context_properties) wglGetCurrentContext(),
-			CL_WGL_HDC_KHR, (cl_context_properties) wglGetCurrentDC(),
-			CL_CONTEXT_PLATFORM, (cl_context_properties)(platform)(), 0};
-		#elif defined(__APPLE__) || defined(MACOSX)
-			CGLContextObj glContext = CGLGetCurrentContext();
-			CGLShareGroupObj shareGroup = CGLGetShareGroup(glContext);
-			cl_context_properties props[] = {
-			CL_CONTEXT_PROPERTY_USE_CGL_SHAREGROUP_APPLE,
-			(cl_context_properties)shareGroup, 0};
-		#endif
-
-		context = cl::Context(CL_DEVICE_TYPE_GPU, props);
- 
-		// get compute devices on default platform
-		vector<cl::Device> all_devices = context.getInfo<CL_CONTEXT_DEVICES>();
-		if (all_devices.size()==0) {
-			HandleFatalError(31, "No devices found. Check OpenCL installation!");
-		}
-
-		// select default compute device
-		device=all_devices[0];
-
-		// veryify CL/GL sharing is supported on device
-		string dev_exts = device.getInfo<CL_DEVICE_EXTENSIONS>();
-		if (dev_exts.find(CL_GL_SHARING_EXT) == string::npos) {
-			HandleFatalError(35, "Device does not support CL/GL sharing!");
-		} else if (device.getInfo<CL_DEVICE_IMAGE_SUPPORT>()!=CL_TRUE) {
-			HandleFatalError(36, "Device does not support OpenCL images!");
-		} else {
-			cout << "Success!\n";
-		}
-
-		// Read kernel source file
-		cl::Program::Sources sources;
-		string sourceCode = readFile("Data\\kernels\\compute.cl");
-		sources.push_back(make_pair(sourceCode.c_str(), sourceCode.length()+1));
-
-		// Make program of the source code in the context
-		program = cl::Program(context, sources);
- 
-		// build kernel program and check for errors
-		cout << "Building OpenCL kernels ... ";
-		if (program.build(all_devices)!=CL_SUCCESS) {
-			cout << "Failed!\n";
-			// log compiler output then stop the application
-			CLBLog("Build log: "+program.getBuildInfo<CL_PROGRAM_BUILD_LOG>(device));
-			HandleFatalError(32, "Error building kernel program.");
-		} else {
-			cout << "Success!\n";
-			//CLBLog("Build log: "+program.getBuildInfo<CL_PROGRAM_BUILD_LOG>(device));
-		}
-
-		// initialize kernel objects
-		switch (sub_rays) {
-			case 0: CR_Kernel = cl::Kernel(program, "ComputeStage0x1"); break;
-			case 1: CR_Kernel = cl::Kernel(program, "ComputeStage0x1"); break;
-			default: CR_Kernel = cl::Kernel(program, "ComputeStage0xN"); break;
-		}
-		
-		CT_Kernel = cl::Kernel(program, "ComputeStage1T");
-		CS_Kernel = cl::Kernel(program, "ComputeStage1S");
-
-		switch (t_depth) {
-		case 1:
-			CL_Kernel = cl::Kernel(program, "ComputeStage2x1");
-			break;
-		case 2:
-			CL_Kernel = cl::Kernel(program, "ComputeStage2x2");
-			break;
-		case 3:
-			CL_Kernel = cl::Kernel(program, "ComputeStage2x3");
-			break;
-		case 4:
-			CL_Kernel = cl::Kernel(program, "ComputeStage2x4");
-			break;
-		default:
-			HandleFatalError(33, "Invalid transparency depth: "+IntToStr(t_depth));
-			break;
-		}
-
-		// create queue to which we will push commands for the device
-		queue = cl::CommandQueue(context, device);
-
-		// get maximum workgroup size for device
-		max_wg_size = (cl_uint)device.getInfo<CL_DEVICE_MAX_WORK_GROUP_SIZE>();
-
-		// print OpenCL info to console
-		PrintCLInfo();
-	}
-	void PrintCLInfo()
-	{
-		string device_name = device.getInfo<CL_DEVICE_NAME>();
-		string device_vendor = device.getInfo<CL_DEVICE_VENDOR>();
-		device_name.pop_back(); device_vendor.pop_back();
-
-		cout << "\nUsing platform: "+platform.getInfo<CL_PLATFORM_NAME>() + "\n";
-		cout << "Using device: "+device_name+" ("+device_vendor+")\n";
-		cout << "OpenCL version: "+device.getInfo<CL_DEVICE_VERSION>() + "\n";
-		cout << "Max parameter size: "+IntToStr((cl_uint)device.getInfo<CL_DEVICE_MAX_PARAMETER_SIZE>())+" KB\n";
-		cout << "Constant buffer size: "+DblToStr((cl_ulong)device.getInfo<CL_DEVICE_MAX_CONSTANT_BUFFER_SIZE>()/1024)+" KB\n";
-		cout << "Local memory size: "+DblToStr((cl_ulong)device.getInfo<CL_DEVICE_LOCAL_MEM_SIZE>()/1024)+" KB\n";
-		cout << "Global memory size: "+DblToStr((cl_ulong)device.getInfo<CL_DEVICE_GLOBAL_MEM_SIZE>()/1024/1024)+" MB\n";
-		cout << "Max compute units: "+IntToStr((cl_uint)device.getInfo<CL_DEVICE_MAX_COMPUTE_UNITS>()) + "\n";
-		cout << "Max workgroup size: "+IntToStr(max_wg_size) + "\n\n";
-	}
-	void RunKernel0(UINT32 ww, UINT32 wh)
-	{
-		queue.enqueueNDRangeKernel(CR_Kernel, cl::NullRange, cl::NDRange(ww, wh), local_range);
-	}
-	void RunKernel1(size_t mX, size_t mY, size_t bX, size_t bY)
-	{
-		queue.enqueueNDRangeKernel(CT_Kernel, cl::NDRange(mX, mY), cl::NDRange(bX, bY), local_range);
-	}
-	void RunKernel2(UINT32 ww, UINT32 wh)
-	{
-		queue.enqueueNDRangeKernel(CL_Kernel, cl::NullRange, cl::NDRange(ww, wh), local_range);
-	}
+#pragma once
+#define __CL_ENABLE_EXCEPTIONS
+#include <CL/cl.hpp>
+#include "ReadWrite.h"
+#include "MathExt.h"
+#include "Timer.h"
+#include <stdio.h>
+#include <cstdlib>
+#include <string>
+#include <iostream>
+
+#ifdef linux
+    #include <GL/glx.h>
+#endif
+
+class CL
+{
+private:
+	cl::Platform platform;
+	cl::Device device;
+	cl::Program program;
+public:
+	cl::NDRange local_range;
+	cl::CommandQueue queue;
+	cl::Context context;
+	cl::Kernel CR_Kernel;
+	cl::Kernel CS_Kernel;
+	cl::Kernel CT_Kernel;
+	cl::Kernel CTP_Kernel;
+	cl::Kernel CW_Kernel;
+	cl::Kernel CWP_Kernel;
+	cl::Kernel CB_Kernel;
+	cl::Kernel TC_Kernel;
+	cl::Kernel TF_Kernel;
+	cl::Kernel BC_Kernel;
+	cl::Kernel CV_Kernel;
+	cl::Kernel CQ_Kernel;
+	cl::Kernel QI_Kernel;
+	cl::Kernel QC_Kernel;
+	cl::Kernel SL_Kernel;
+	cl::Kernel SA_Kernel;
+	cl::Kernel RS_Kernel;
+	cl::Kernel LT_Kernel;
+	cl::Kernel LC_Kernel;
+	cl::Kernel RI_Kernel;
+	cl::Kernel RF_Kernel;
+	cl::Kernel CL_Kernel;
+	cl::Kernel ED_Kernel;
+	cl::Kernel RA_Kernel;
+	cl::Kernel LA_Kernel;
+	cl::Kernel TA_Kernel;
+	UINT32 max_wg_size;
+	UINT32 max_cu_count;
+	vector<cl::Event> frame_events;
+	vector<cl::Event> frame_starts;
+	vector<bool> frame_pending;
+	vector<bool> frame_ready;
+	UINT32 frames_in_flight;
+	UINT32 frame_slot;
+	float build_time;
+	bool build_cached;
+	bool profiling;
+public:
+	void Initialize(unsigned char sub_rays, unsigned char t_depth, const string build_opts, UINT32 frames=1, bool aa_adaptive=false, bool profile=false)
+	{
+		cout << "Initializing OpenCL ... ";
+
+		// get all platforms (drivers)
+		vector<cl::Platform> all_platforms;
+		cl::Platform::get(&all_platforms);
+		if (all_platforms.size()==0) {
+			HandleFatalError(30, "No platforms found. Check OpenCL installation!");
+		}
+		// select default platform
+		platform=all_platforms[0];
+
+		#ifdef linux
+			cl_context_properties props[] = {
+			CL_GL_CONTEXT_KHR, (cl_context_properties) glXGetCurrentContext(),
+			CL_GLX_DISPLAY_KHR, (cl_context_properties) glXGetCurrentDisplay(),
+			CL_CONTEXT_PLATFORM, (cl_context_properties)(platform)(), 0};
+		#elif defined WIN32 || defined _WIN32
+			cl_context_properties props[] = {
+			CL_GL_CONTEXT_KHR, (cl_context_properties) wglGetCurrentContext(),
+			CL_WGL_HDC_KHR, (cl_context_properties) wglGetCurrentDC(),
+			CL_CONTEXT_PLATFORM, (cl_context_properties)(platform)(), 0};
+		#elif defined(__APPLE__) || defined(MACOSX)
+			CGLContextObj glContext = CGLGetCurrentContext();
+			CGLShareGroupObj shareGroup = CGLGetShareGroup(glContext);
+			cl_context_properties props[] = {
+			CL_CONTEXT_PROPERTY_USE_CGL_SHAREGROUP_APPLE,
+			(cl_context_properties)shareGroup, 0};
+		#endif
+
+		context = cl::Context(CL_DEVICE_TYPE_GPU, props);
+ 
+		// get compute devices on default platform
+		vector<cl::Device> all_devices = context.getInfo<CL_CONTEXT_DEVICES>();
+		if (all_devices.size()==0) {
+			HandleFatalError(31, "No devices found. Check OpenCL installation!");
+		}
+
+		// select default compute device
+		device=all_devices[0];
+
+		// veryify CL/GL sharing is supported on device
+		string dev_exts = device.getInfo<CL_DEVICE_EXTENSIONS>();
+		if (dev_exts.find(CL_GL_SHARING_EXT) == string::npos) {
+			HandleFatalError(35, "Device does not support CL/GL sharing!");
+		} else if (device.getInfo<CL_DEVICE_IMAGE_SUPPORT>()!=CL_TRUE) {
+			HandleFatalError(36, "Device does not support OpenCL images!");
+		} else {
+			cout << "Success!\n";
+		}
+
+		if (t_depth < 1 || t_depth > 4) {
+			HandleFatalError(33, "Invalid transparency depth: "+IntToStr(t_depth));
+		}
+
+		// Read kernel source file
+		string sourceCode = readFile("Data\\kernels\\compute.cl");
+
+		// cached binaries are only valid for the same device, driver, options and source
+		string cacheKey = device.getInfo<CL_DEVICE_NAME>()+"\n"+device.getInfo<CL_DRIVER_VERSION>()+"\n"+
+						  build_opts+"\n"+HashToStr(HashString(sourceCode));
+		string cacheFile = "Data\\kernels\\compute_"+HashToStr(HashString(cacheKey))+".bin";
+
+		Timer buildTimer;
+		buildTimer.StartWatch();
+
+		cout << "Building OpenCL kernels ... ";
+		build_cached = LoadProgramBinary(cacheFile, cacheKey, build_opts);
+
+		if (!build_cached) {
+			cl::Program::Sources sources;
+			sources.push_back(make_pair(sourceCode.c_str(), sourceCode.length()+1));
+
+			// Make program of the source code in the context
+			program = cl::Program(context, sources);
+ 
+			// build kernel program and check for errors
+			if (program.build(all_devices, build_opts.c_str())!=CL_SUCCESS) {
+				cout << "Failed!\n";
+				// log compiler output then stop the application
+				CLBLog("Build log: "+program.getBuildInfo<CL_PROGRAM_BUILD_LOG>(device));
+				HandleFatalError(32, "Error building kernel program.");
+			}
+
+			SaveProgramBinary(cacheFile, cacheKey, all_devices);
+		}
+
+		cout << "Success!\n";
+		buildTimer.StopWatch();
+		build_time = buildTimer.GetTimeMilli();
+
+		// initialize kernel objects
+		switch (sub_rays) {
+			case 0: CR_Kernel = cl::Kernel(program, "ComputeStage0x1"); break;
+			case 1: CR_Kernel = cl::Kernel(program, "ComputeStage0x1"); break;
+			default: CR_Kernel = cl::Kernel(program, "ComputeStage0xN"); break;
+		}
+		
+		CT_Kernel = cl::Kernel(program, "ComputeStage1T");
+		CTP_Kernel = cl::Kernel(program, "ComputeStage1TP");
+		CS_Kernel = cl::Kernel(program, "ComputeStage1S");
+		CW_Kernel = cl::Kernel(program, "ComputeStage1W");
+		CWP_Kernel = cl::Kernel(program, "ComputeStage1WP");
+		CB_Kernel = cl::Kernel(program, "ComputeStage1B");
+		TC_Kernel = cl::Kernel(program, "ComputeTileCount");
+		TF_Kernel = cl::Kernel(program, "ComputeTileFill");
+		BC_Kernel = cl::Kernel(program, "ComputeBufferClear");
+		CV_Kernel = cl::Kernel(program, "ComputeStage1V");
+		CQ_Kernel = cl::Kernel(program, "ComputeStage1Q");
+		QI_Kernel = cl::Kernel(program, "ComputeQueueInit");
+		QC_Kernel = cl::Kernel(program, "ComputeQueueCompact");
+		SL_Kernel = cl::Kernel(program, "ComputeScanLocal");
+		SA_Kernel = cl::Kernel(program, "ComputeScanAdd");
+		RS_Kernel = cl::Kernel(program, "ComputeResolve");
+		LT_Kernel = cl::Kernel(program, "ComputeStage1L");
+		LC_Kernel = cl::Kernel(program, "ComputeLightClusters");
+		RI_Kernel = cl::Kernel(program, "ComputeReflectInit");
+		RF_Kernel = cl::Kernel(program, "ComputeStage1R");
+		TA_Kernel = cl::Kernel(program, "ComputeStage2T");
+
+		// one kernel covers every depth since T_DEPTH is defined when the program is built
+		CL_Kernel = cl::Kernel(program, "ComputeStage2");
+
+		// adaptive anti-aliasing traces one ray per pixel then adds sub-rays only where needed
+		if (aa_adaptive) {
+			CR_Kernel = cl::Kernel(program, "ComputeStage0x1");
+			CL_Kernel = cl::Kernel(program, "ComputeStage2x1");
+			ED_Kernel = cl::Kernel(program, "ComputeEdgeDetect");
+			RA_Kernel = cl::Kernel(program, "ComputeStage0A");
+			LA_Kernel = cl::Kernel(program, "ComputeStage2A");
+		}
+
+		// create queue to which we will push commands for the device, timestamps are only kept when frames are timed
+		profiling = profile;
+		queue = cl::CommandQueue(context, device, profiling ? CL_QUEUE_PROFILING_ENABLE : 0);
+
+		// the in-order queue keeps each frame's commands in sequence, so a frame
+		// only needs one event to tell the host when its resources are free again
+		frames_in_flight = max(frames, (UINT32)1);
+		frame_events.resize(frames_in_flight);
+		frame_starts.resize(frames_in_flight);
+		frame_pending.assign(frames_in_flight, false);
+		frame_ready.assign(frames_in_flight, false);
+		frame_slot = frames_in_flight - 1;
+
+		// get maximum workgroup size for device
+		max_wg_size = (cl_uint)device.getInfo<CL_DEVICE_MAX_WORK_GROUP_SIZE>();
+
+		// get number of compute units for persistent work groups
+		max_cu_count = (cl_uint)device.getInfo<CL_DEVICE_MAX_COMPUTE_UNITS>();
+
+		// print OpenCL info to console
+		PrintCLInfo();
+	}
+	void PrintCLInfo()
+	{
+		string device_name = device.getInfo<CL_DEVICE_NAME>();
+		string device_vendor = device.getInfo<CL_DEVICE_VENDOR>();
+		device_name.pop_back(); device_vendor.pop_back();
+
+		cout << "\nUsing platform: "+platform.getInfo<CL_PLATFORM_NAME>() + "\n";
+		cout << "Using device: "+device_name+" ("+device_vendor+")\n";
+		cout << "OpenCL version: "+device.getInfo<CL_DEVICE_VERSION>() + "\n";
+		cout << "Max parameter size: "+IntToStr((cl_uint)device.getInfo<CL_DEVICE_MAX_PARAMETER_SIZE>())+" KB\n";
+		cout << "Constant buffer size: "+DblToStr((cl_ulong)device.getInfo<CL_DEVICE_MAX_CONSTANT_BUFFER_SIZE>()/1024)+" KB\n";
+		cout << "Local memory size: "+DblToStr((cl_ulong)device.getInfo<CL_DEVICE_LOCAL_MEM_SIZE>()/1024)+" KB\n";
+		cout << "Global memory size: "+DblToStr((cl_ulong)device.getInfo<CL_DEVICE_GLOBAL_MEM_SIZE>()/1024/1024)+" MB\n";
+		cout << "Max compute units: "+IntToStr((cl_uint)device.getInfo<CL_DEVICE_MAX_COMPUTE_UNITS>()) + "\n";
+		cout << "Max workgroup size: "+IntToStr(max_wg_size) + "\n";
+		cout << "Program build: "+DblToStr(build_time)+" ms ("+string(build_cached ? "cached binary" : "compiled from source")+")\n\n";
+	}
+	// creates the program from a binary saved by an earlier run, false if there is none or it fails to build
+	bool LoadProgramBinary(const string& cacheFile, const string& cacheKey, const string& build_opts)
+	{
+		vector<unsigned char> binary;
+		if (!readBinaryFile(cacheFile, cacheKey, binary)) { return false; }
+
+		vector<cl::Device> devices(1, device);
+		cl::Program::Binaries binaries(1, make_pair((const void*)binary.data(), binary.size()));
+
+		try {
+			program = cl::Program(context, devices, binaries);
+			program.build(devices, build_opts.c_str());
+		} catch (cl::Error&) {
+			return false;
+		}
+
+		return true;
+	}
+	// saves the binary of the selected device so the next run can skip compiling
+	void SaveProgramBinary(const string& cacheFile, const string& cacheKey, const vector<cl::Device>& devices)
+	{
+		vector<size_t> sizes = program.getInfo<CL_PROGRAM_BINARY_SIZES>();
+		vector<vector<unsigned char>> binaries(sizes.size());
+		vector<unsigned char*> pointers(sizes.size());
+
+		for (size_t d = 0; d < sizes.size(); d++) {
+			binaries[d].resize(sizes[d]);
+			pointers[d] = binaries[d].data();
+		}
+
+		if (clGetProgramInfo(program(), CL_PROGRAM_BINARIES, sizeof(unsigned char*)*pointers.size(), pointers.data(), NULL) != CL_SUCCESS) { return; }
+
+		for (size_t d = 0; d < devices.size() && d < sizes.size(); d++) {
+			if (devices[d]() == device() && sizes[d] > 0) { writeBinaryFile(cacheFile, cacheKey, binaries[d]); }
+		}
+	}
+	// moves to the slot of the oldest frame and waits until the device has finished it
+	void BeginFrame()
+	{
+		frame_slot = (frame_slot + 1) % frames_in_flight;
+		WaitFrame(frame_slot);
+		frame_ready[frame_slot] = false;
+		if (profiling) { queue.enqueueMarkerWithWaitList(NULL, &frame_starts[frame_slot]); }
+	}
+	// marks the end of the frame and hands its commands to the device without waiting
+	void EndFrame()
+	{
+		queue.enqueueMarkerWithWaitList(NULL, &frame_events[frame_slot]);
+		queue.flush();
+		frame_pending[frame_slot] = true;
+	}
+	// returns false if the slot has no finished frame to show
+	bool WaitFrame(UINT32 slot)
+	{
+		if (frame_pending[slot]) {
+			frame_events[slot].wait();
+			frame_pending[slot] = false;
+			frame_ready[slot] = true;
+		}
+		return frame_ready[slot];
+	}
+	UINT32 OldestFrame()
+	{
+		return (frame_slot + 1) % frames_in_flight;
+	}
+	// device time in ms between the markers around a finished frame, needs a profiling queue
+	float FrameTime(UINT32 slot)
+	{
+		if (!profiling || !frame_ready[slot]) { return 0.0f; }
+		cl_ulong start = frame_starts[slot].getProfilingInfo<CL_PROFILING_COMMAND_START>();
+		cl_ulong end = frame_events[slot].getProfilingInfo<CL_PROFILING_COMMAND_END>();
+		return (float)((end - start) / 1000000.0);
+	}
+	void RunKernel0(UINT32 ww, UINT32 wh)
+	{
+		queue.enqueueNDRangeKernel(CR_Kernel, cl::NullRange, cl::NDRange(ww, wh), local_range);
+	}
+	void RunKernel1(size_t mX, size_t mY, size_t bX, size_t bY)
+	{
+		queue.enqueueNDRangeKernel(CT_Kernel, cl::NDRange(mX, mY), cl::NDRange(bX, bY), local_range);
+	}
+	void RunKernelV(UINT32 count)
+	{
+		queue.enqueueNDRangeKernel(CV_Kernel, cl::NullRange, cl::NDRange(((count+63)/64)*64), cl::NDRange(64));
+	}
+	void RunKernelQ(cl::Kernel& kernel, UINT32 count, UINT32 group)
+	{
+		queue.enqueueNDRangeKernel(kernel, cl::NullRange, cl::NDRange(((count+group-1)/group)*group), cl::NDRange(group));
+	}
+	void RunKernelP(cl::Kernel& kernel, UINT32 groups, UINT32 group)
+	{
+		queue.enqueueNDRangeKernel(kernel, cl::NullRange, cl::NDRange(groups*group), cl::NDRange(group));
+	}
+	void RunKernelW(UINT32 ww, UINT32 wh)
+	{
+		queue.enqueueNDRangeKernel(CW_Kernel, cl::NullRange, cl::NDRange(ww, wh), local_range);
+	}
+	void RunKernelS(UINT32 ww, UINT32 wh)
+	{
+		queue.enqueueNDRangeKernel(CS_Kernel, cl::NullRange, cl::NDRange(ww, wh), local_range);
+	}
+	void RunKernelB(UINT32 ww, UINT32 wh)
+	{
+		queue.enqueueNDRangeKernel(CB_Kernel, cl::NullRange, cl::NDRange(ww, wh), local_range);
+	}
+	void RunKernel2(UINT32 ww, UINT32 wh)
+	{
+		queue.enqueueNDRangeKernel(CL_Kernel, cl::NullRange, cl::NDRange(ww, wh), local_range);
+	}
+	void RunKernelT(UINT32 ww, UINT32 wh)
+	{
+		queue.enqueueNDRangeKernel(TA_Kernel, cl::NullRange, cl::NDRange(ww, wh), local_range);
+	}
+	void RunKernelE(UINT32 ww, UINT32 wh)
+	{
+		queue.enqueueNDRangeKernel(ED_Kernel, cl::NullRange, cl::NDRange(ww, wh), local_range);
+	}
 };
\ No newline at end of file